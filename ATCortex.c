@@ -4,21 +4,17 @@
 #include "send_msg_handle.h"
 #include "urc_handle.h"
 #include "recv_data_handle.h"
+#include "urc_defer.h"
+#include "timer_wheel.h"
+#include "result_cache.h"
+#include "wait_pool.h"
 
 
-//检查发送消息是否超时
-static void check_send_timeout(struct atc_context *context){
-    if(context->current_send_task != NULL){
-        uint32_t current_time = _atc_time_get();
-        if(current_time - context->current_send_task->timestamp >= context->current_send_task->timeout){
-            LOG_WARN("send task timeout:%.*s", context->current_send_task->length, context->current_send_task->data);
-            //超时，返回TIMEOUT结果
-            command_end_handle(context, ATC_TIMEOUT);
-        }
-    }
+enum atc_result atc_init(struct atc_context *context){
+    return atc_init_ex(context, NULL);
 }
 
-enum atc_result atc_init(struct atc_context *context){
+enum atc_result atc_init_ex(struct atc_context *context, const struct atc_config *config){
     LOG_TRACE;
     //初始化接收处理
     if(recv_data_init(context) != ATC_SUCCESS){
@@ -32,15 +28,35 @@ enum atc_result atc_init(struct atc_context *context){
         return ATC_ERROR;
     }
     LOG_TRACE;
-    if(send_msg_queue_init(context)!=ATC_SUCCESS){
+    if(send_msg_queue_init(context, config)!=ATC_SUCCESS){
         LOG_ERR("Failed to initialize send message queue");
         return ATC_ERROR;
     }
+    if(send_task_pool_init(context, config) != ATC_SUCCESS){
+        LOG_ERR("Failed to initialize send task pool");
+        return ATC_ERROR;
+    }
+    if(wait_pool_init(context, config) != ATC_SUCCESS){
+        LOG_ERR("Failed to initialize wait semaphore pool");
+        return ATC_ERROR;
+    }
+    if(timer_wheel_init(context) != ATC_SUCCESS){
+        LOG_ERR("Failed to initialize timer wheel");
+        return ATC_ERROR;
+    }
     LOG_TRACE;
     if(urc_init(context) != ATC_SUCCESS){
         LOG_ERR("Failed to initialize URC handler list");
         return ATC_ERROR;
     }
+    if(urc_defer_init(context) != ATC_SUCCESS){
+        LOG_ERR("Failed to initialize URC defer queue");
+        return ATC_ERROR;
+    }
+    if(result_cache_init(context) != ATC_SUCCESS){
+        LOG_ERR("Failed to initialize result cache");
+        return ATC_ERROR;
+    }
     LOG_TRACE;
     //创建唤醒信号量
     context->wake_semaphore = g_atc_interface.atc_semaphore_create_binary();
@@ -53,27 +69,21 @@ enum atc_result atc_init(struct atc_context *context){
 }
 void atc_process(struct atc_context *context){
     for(;;){
-        uint32_t wait_ms = ATC_TIMEOUT_MAX;
-
         //处理"外部API"消息队列
         extern_msg_handle(context);
-        //处理"发送"消息队列
-        send_msg_handle(context);
         //处理接收缓冲区
         recv_data_handle(context);
-        //检查发送消息是否超时
-        check_send_timeout(context);
-
-        //计算剩余超时
-        if(context->current_send_task != NULL){
-            uint32_t elapsed = _atc_time_get() - context->current_send_task->timestamp;
-            if(elapsed < context->current_send_task->timeout){
-                wait_ms = context->current_send_task->timeout - elapsed;
-            }else{
-                wait_ms = 0;  //已超时，下一轮立即处理
-            }
-        }
+        //异步发送完成：继续发送下一段，或结束发送期间已结束的命令
+        send_tx_complete_handle(context);
+        //执行到期的定时器：命令超时、排队超时、URC限流交付
+        timer_wheel_run(context);
+        //处理"发送"消息队列。放在命令结束之后，排队的命令在同一轮立即发送，不需要额外唤醒
+        send_msg_handle(context);
+        //发送上传载荷，每轮一块，还有剩余时不阻塞
+        bool tx_pending = send_payload_handle(context);
 
+        //阻塞到最近的定时器到期
+        uint32_t wait_ms = tx_pending ? 0 : timer_wheel_wait_ms(context);
         g_atc_interface.atc_semaphore_take(context->wake_semaphore, wait_ms);
     }
 }
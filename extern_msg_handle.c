@@ -8,11 +8,20 @@
 #include "include/ATCortex.h"
 #include "log.h"
 #include <stdio.h>
+#include <string.h>
 #include "urc_handle.h"
+#include "result_code.h"
+#include "wait_pool.h"
+#include "send_msg_handle.h"
+#include "urc_defer.h"
 
 enum msg_type{
     MSG_TYPE_URC_REGISTER,
     MSG_TYPE_URC_UNREGISTER,
+    MSG_TYPE_RESULT_CODE_REGISTER,
+    MSG_TYPE_RESULT_CODE_UNREGISTER,
+    MSG_TYPE_CMD_CANCEL,
+    MSG_TYPE_CMD_RELEASE,
 };
 
 struct msg{
@@ -22,10 +31,13 @@ struct msg{
     void *semaphore;             // 通用同步信号量，NULL=异步
 };
 
-// 注册消息（通过 void *data 携带，堆分配）
+// 注册消息（通过 void *data 携带，堆分配），一条消息可携带多个条目
 struct urc_register_msg {
-    struct urc_handler_entry entry;  // prefix + handler
-    int *out_id;                     // 指向调用者栈上变量，事件循环填入分配的ID
+    size_t count;
+    int *out_ids;                    // 同步时指向调用者数组，异步时指向消息末尾；事件循环填入分配的ID
+    atc_urc_register_done_t done;    // 异步完成回调，在事件循环中调用，可以为 NULL
+    void *done_arg;
+    struct urc_handler_entry entries[];  // prefix + handler + options
 };
 
 // 反注册消息（通过 void *data 携带，堆分配）
@@ -34,10 +46,50 @@ struct urc_unregister_msg {
     enum atc_result *out_result;     // 指向调用者栈上变量，事件循环填入结果
 };
 
+// 结果码注册/反注册消息（通过 void *data 携带，堆分配）
+struct result_code_msg {
+    char code[ATC_RESULT_CODE_MAX_SIZE];
+    enum atc_result result;          // 注册时的结果，反注册时不使用
+    enum atc_result *out_result;     // 指向调用者栈上变量，事件循环填入结果
+};
+
 static void msg_free(void *data){
     if(data) g_atc_interface.atc_free(data);
 }
 
+// 同步投递消息：创建信号量，投递到外部API队列，阻塞等待事件循环处理完成
+// 失败时释放 msg->data
+static enum atc_result extern_msg_send_wait(struct atc_context *context, struct msg *msg){
+    // 检查信号量函数是否实现
+    if(g_atc_interface.atc_semaphore_create_binary == NULL || g_atc_interface.atc_semaphore_give == NULL
+        || g_atc_interface.atc_semaphore_take == NULL || g_atc_interface.atc_semaphore_delete == NULL){
+        LOG_ERR("Semaphore functions are not implemented");
+        msg->free_fn(msg->data);
+        return ATC_ERROR;
+    }
+    // 从池中取同步信号量
+    msg->semaphore = wait_semaphore_acquire(context);
+    if(msg->semaphore == NULL){
+        LOG_ERR("Failed to create semaphore for sync api msg, type:%d", msg->type);
+        msg->free_fn(msg->data);
+        return ATC_ERROR;
+    }
+    enum atc_result ret = g_atc_interface.atc_queue_send(context->external_api_queue, msg, 1000);
+    if(ret != ATC_SUCCESS){
+        msg->free_fn(msg->data);
+        wait_semaphore_release(context, msg->semaphore);
+        LOG_ERR("Failed to send api msg to external api queue, type:%d", msg->type);
+        return ATC_ERROR;
+    }
+    // 唤醒阻塞等待的处理线程
+    g_atc_interface.atc_semaphore_give(context->wake_semaphore);
+    // 阻塞等待事件循环处理完成
+    g_atc_interface.atc_semaphore_take(msg->semaphore, ATC_TIMEOUT_MAX);
+    // 归还信号量
+    wait_semaphore_release(context, msg->semaphore);
+    return ATC_SUCCESS;
+}
+
 enum atc_result extern_msg_queue_init(struct atc_context *context){
     context->external_api_queue = g_atc_interface.atc_queue_create(5, sizeof(struct msg));
     if(context->external_api_queue == NULL){
@@ -48,78 +100,145 @@ enum atc_result extern_msg_queue_init(struct atc_context *context){
 }
 
 int atc_urc_register(struct atc_context *context , const char *prefix, atc_urc_handler_t handler){
-    if(context == NULL || prefix == NULL || handler == NULL){
-        return -1;
+    return atc_urc_register_ex(context, prefix, handler, NULL);
+}
+
+// 检查并填充注册条目，失败返回false
+static bool urc_entry_fill(struct urc_handler_entry *entry, const struct atc_urc_registration *reg){
+    const struct atc_urc_options *options = reg->options;
+    bool has_payload = options != NULL && options->payload_length != NULL;
+    if(reg->prefix == NULL || (reg->handler == NULL && !has_payload)){
+        return false;
     }
-    if(prefix[0] == '\0'){
+    if(reg->prefix[0] == '\0'){
         LOG_ERR("URC prefix is empty");
-        return -1;
+        return false;
     }
-    // 检查信号量函数是否实现
-    if(g_atc_interface.atc_semaphore_create_binary == NULL || g_atc_interface.atc_semaphore_give == NULL
-        || g_atc_interface.atc_semaphore_take == NULL || g_atc_interface.atc_semaphore_delete == NULL){
-        LOG_ERR("Semaphore functions are not implemented");
-        return -1;
+    //负载直接从接收缓冲区交给回调，只能在事件循环中处理
+    if(has_payload && (options->payload_handler == NULL || options->deferred || options->min_interval_ms != 0)){
+        LOG_ERR("URC payload requires payload_handler and cannot be deferred or rate limited");
+        return false;
+    }
+    if(options != NULL && options->aggregate != ATC_URC_AGGREGATE_NONE){
+        if(has_payload || (options->aggregate == ATC_URC_AGGREGATE_UNTIL_TERMINATOR
+                            && (options->aggregate_terminator == NULL || options->aggregate_terminator[0] == '\0'))){
+            LOG_ERR("Invalid URC aggregate options");
+            return false;
+        }
+    }
+    int count = snprintf(entry->prefix, sizeof(entry->prefix), "%s", reg->prefix);
+    if(count < 0 || (size_t)count >= sizeof(entry->prefix)){
+        LOG_ERR("URC prefix too long");
+        return false;
+    }
+    entry->handler = reg->handler;
+    if(options != NULL){
+        entry->options = *options;
+    }
+    else{
+        memset(&entry->options, 0, sizeof(entry->options));
+    }
+    return true;
+}
+
+// 创建注册消息，一条消息携带全部条目。异步时分配的ID存放在消息末尾
+static struct urc_register_msg *urc_register_msg_create(const struct atc_urc_registration *regs, size_t count, bool async){
+    size_t size = sizeof(struct urc_register_msg) + sizeof(struct urc_handler_entry) * count;
+    if(async){
+        size += sizeof(int) * count;
     }
-    // 创建注册消息
-    struct urc_register_msg *reg_msg = g_atc_interface.atc_malloc(sizeof(struct urc_register_msg));
+    struct urc_register_msg *reg_msg = g_atc_interface.atc_malloc(size);
     if(reg_msg == NULL){
         LOG_ERR("Failed to allocate memory for urc_register_msg");
-        return -1;
+        return NULL;
     }
-    int count = snprintf(reg_msg->entry.prefix, sizeof(reg_msg->entry.prefix), "%s", prefix);
-    if(count < 0 || count >= sizeof(reg_msg->entry.prefix)){
-        LOG_ERR("URC prefix too long");
-        g_atc_interface.atc_free(reg_msg);
-        return -1;
+    memset(reg_msg, 0, size);
+    for(size_t i = 0; i < count; i++){
+        if(!urc_entry_fill(&reg_msg->entries[i], &regs[i])){
+            LOG_ERR("Invalid URC registration at index %zu", i);
+            g_atc_interface.atc_free(reg_msg);
+            return NULL;
+        }
     }
-    reg_msg->entry.handler = handler;
-    // id 由事件循环分配
+    reg_msg->count = count;
+    if(async){
+        reg_msg->out_ids = (int *)&reg_msg->entries[count];
+    }
+    return reg_msg;
+}
+
+int atc_urc_register_ex(struct atc_context *context, const char *prefix, atc_urc_handler_t handler, const struct atc_urc_options *options){
+    struct atc_urc_registration reg = {
+        .prefix = prefix,
+        .handler = handler,
+        .options = options,
+    };
     int assigned_id = -1;
-    reg_msg->out_id = &assigned_id;
+    atc_urc_register_batch(context, &reg, 1, &assigned_id);
+    return assigned_id;
+}
 
-    // 创建同步信号量
-    void *sem = g_atc_interface.atc_semaphore_create_binary();
-    if(sem == NULL){
-        LOG_ERR("Failed to create semaphore for sync urc register");
-        g_atc_interface.atc_free(reg_msg);
-        return -1;
+enum atc_result atc_urc_register_batch(struct atc_context *context, const struct atc_urc_registration *regs, size_t count, int *ids){
+    if(context == NULL || regs == NULL || count == 0 || ids == NULL){
+        return ATC_ERROR;
+    }
+    for(size_t i = 0; i < count; i++){
+        ids[i] = -1;
+    }
+    struct urc_register_msg *reg_msg = urc_register_msg_create(regs, count, false);
+    if(reg_msg == NULL){
+        return ATC_ERROR;
     }
+    // id 由事件循环分配，直接写入调用者数组
+    reg_msg->out_ids = ids;
 
     struct msg msg = {
         .type = MSG_TYPE_URC_REGISTER,
         .data = reg_msg,
         .free_fn = msg_free,
-        .semaphore = sem,
     };
+    if(extern_msg_send_wait(context, &msg) != ATC_SUCCESS){
+        return ATC_ERROR;
+    }
+    for(size_t i = 0; i < count; i++){
+        if(ids[i] <= 0){
+            return ATC_ERROR;
+        }
+    }
+    return ATC_SUCCESS;
+}
 
-    enum atc_result ret = g_atc_interface.atc_queue_send(context->external_api_queue, &msg, 1000);
-    if(ret != ATC_SUCCESS){
+enum atc_result atc_urc_register_async(struct atc_context *context, const struct atc_urc_registration *regs, size_t count,
+                                        atc_urc_register_done_t done, void *arg){
+    if(context == NULL || regs == NULL || count == 0){
+        return ATC_ERROR;
+    }
+    struct urc_register_msg *reg_msg = urc_register_msg_create(regs, count, true);
+    if(reg_msg == NULL){
+        return ATC_ERROR;
+    }
+    reg_msg->done = done;
+    reg_msg->done_arg = arg;
+
+    struct msg msg = {
+        .type = MSG_TYPE_URC_REGISTER,
+        .data = reg_msg,
+        .free_fn = msg_free,
+    };
+    // 不等待：可在URC回调内调用，队列满时立即失败
+    if(g_atc_interface.atc_queue_send(context->external_api_queue, &msg, 0) != ATC_SUCCESS){
+        LOG_ERR("Failed to send api msg to external api queue, type:%d", msg.type);
         g_atc_interface.atc_free(reg_msg);
-        g_atc_interface.atc_semaphore_delete(sem);
-        LOG_ERR("Failed to send urc register message to external api queue");
-        return -1;
+        return ATC_ERROR;
     }
-    // 唤醒阻塞等待的处理线程
     g_atc_interface.atc_semaphore_give(context->wake_semaphore);
-    // 阻塞等待事件循环处理完成
-    g_atc_interface.atc_semaphore_take(sem, ATC_TIMEOUT_MAX);
-    // 清理
-    g_atc_interface.atc_semaphore_delete(sem);
-
-    return assigned_id;
+    return ATC_SUCCESS;
 }
 
 enum atc_result atc_urc_unregister(struct atc_context *context, int id){
     if(context == NULL || id <= 0){
         return ATC_ERROR;
     }
-    // 检查信号量函数是否实现
-    if(g_atc_interface.atc_semaphore_create_binary == NULL || g_atc_interface.atc_semaphore_give == NULL
-        || g_atc_interface.atc_semaphore_take == NULL || g_atc_interface.atc_semaphore_delete == NULL){
-        LOG_ERR("Semaphore functions are not implemented");
-        return ATC_ERROR;
-    }
     // 创建反注册消息
     struct urc_unregister_msg *unreg_msg = g_atc_interface.atc_malloc(sizeof(struct urc_unregister_msg));
     if(unreg_msg == NULL){
@@ -131,38 +250,105 @@ enum atc_result atc_urc_unregister(struct atc_context *context, int id){
     enum atc_result result = ATC_ERROR;
     unreg_msg->out_result = &result;
 
-    // 创建同步信号量
-    void *sem = g_atc_interface.atc_semaphore_create_binary();
-    if(sem == NULL){
-        LOG_ERR("Failed to create semaphore for sync urc unregister");
-        g_atc_interface.atc_free(unreg_msg);
-        return ATC_ERROR;
-    }
-
     struct msg msg = {
         .type = MSG_TYPE_URC_UNREGISTER,
         .data = unreg_msg,
         .free_fn = msg_free,
-        .semaphore = sem,
     };
+    if(extern_msg_send_wait(context, &msg) != ATC_SUCCESS){
+        return ATC_ERROR;
+    }
+    if(result == ATC_SUCCESS){
+        //正在派发的延迟处理函数执行完才返回
+        urc_defer_wait_cancelled(context, id);
+    }
+    return result;
+}
 
-    enum atc_result ret = g_atc_interface.atc_queue_send(context->external_api_queue, &msg, 1000);
-    if(ret != ATC_SUCCESS){
-        g_atc_interface.atc_free(unreg_msg);
-        g_atc_interface.atc_semaphore_delete(sem);
-        LOG_ERR("Failed to send urc unregister message to external api queue");
+// 结果码注册/反注册的公共部分
+static enum atc_result result_code_msg_send(struct atc_context *context, enum msg_type type, const char *code, enum atc_result code_result){
+    if(context == NULL || code == NULL || code[0] == '\0'){
         return ATC_ERROR;
     }
-    // 唤醒阻塞等待的处理线程
-    g_atc_interface.atc_semaphore_give(context->wake_semaphore);
-    // 阻塞等待事件循环处理完成
-    g_atc_interface.atc_semaphore_take(sem, ATC_TIMEOUT_MAX);
-    // 清理
-    g_atc_interface.atc_semaphore_delete(sem);
+    struct result_code_msg *rc_msg = g_atc_interface.atc_malloc(sizeof(struct result_code_msg));
+    if(rc_msg == NULL){
+        LOG_ERR("Failed to allocate memory for result_code_msg");
+        return ATC_ERROR;
+    }
+    int count = snprintf(rc_msg->code, sizeof(rc_msg->code), "%s", code);
+    if(count < 0 || (size_t)count >= sizeof(rc_msg->code)){
+        LOG_ERR("Result code too long");
+        g_atc_interface.atc_free(rc_msg);
+        return ATC_ERROR;
+    }
+    rc_msg->result = code_result;
+    enum atc_result result = ATC_ERROR;
+    rc_msg->out_result = &result;
 
+    struct msg msg = {
+        .type = type,
+        .data = rc_msg,
+        .free_fn = msg_free,
+    };
+    if(extern_msg_send_wait(context, &msg) != ATC_SUCCESS){
+        return ATC_ERROR;
+    }
     return result;
 }
 
+enum atc_result atc_result_code_register(struct atc_context *context, const char *code, enum atc_result result){
+    return result_code_msg_send(context, MSG_TYPE_RESULT_CODE_REGISTER, code, result);
+}
+
+enum atc_result atc_result_code_unregister(struct atc_context *context, const char *code){
+    return result_code_msg_send(context, MSG_TYPE_RESULT_CODE_UNREGISTER, code, ATC_ERROR);
+}
+
+// 命令句柄消息：data 为句柄本身，由事件循环处理，不释放
+static enum atc_result cmd_msg_send(struct atc_cmd *cmd, enum msg_type type, uint32_t timeout){
+    struct msg msg = {
+        .type = type,
+        .data = cmd,
+    };
+    if(g_atc_interface.atc_queue_send(cmd->context->external_api_queue, &msg, timeout) != ATC_SUCCESS){
+        LOG_ERR("Failed to send api msg to external api queue, type:%d", msg.type);
+        return ATC_ERROR;
+    }
+    g_atc_interface.atc_semaphore_give(cmd->context->wake_semaphore);
+    return ATC_SUCCESS;
+}
+
+enum atc_result atc_cmd_cancel(struct atc_cmd *cmd){
+    if(cmd == NULL){
+        return ATC_ERROR;
+    }
+    if(cmd->finished){
+        return ATC_SUCCESS;
+    }
+    // 不等待：可在回调内调用，队列满时立即失败，调用者可以重试
+    if(cmd_msg_send(cmd, MSG_TYPE_CMD_CANCEL, 0) != ATC_SUCCESS){
+        return ATC_ERROR;
+    }
+    cmd->cancel_posted = true;
+    return ATC_SUCCESS;
+}
+
+void atc_cmd_release(struct atc_cmd *cmd){
+    if(cmd == NULL){
+        return;
+    }
+    // 已获取完成通知且没有未处理的取消消息，事件循环不再访问句柄，直接回收。
+    // 投递过取消消息时经队列释放，排在取消消息之后处理
+    if(cmd->finished && !cmd->cancel_posted){
+        cmd_free(cmd->context, cmd, true);
+        return;
+    }
+    // 释放消息丢失时句柄永远不会回收，队列满时一直等待
+    if(cmd_msg_send(cmd, MSG_TYPE_CMD_RELEASE, ATC_TIMEOUT_MAX) != ATC_SUCCESS){
+        LOG_ERR("Failed to release atc_cmd %p", (void *)cmd);
+    }
+}
+
 void extern_msg_handle(struct atc_context *context){
     struct msg rmsg;
     while(g_atc_interface.atc_queue_recv(context->external_api_queue, &rmsg, 0) == ATC_SUCCESS){
@@ -170,10 +356,12 @@ void extern_msg_handle(struct atc_context *context){
         switch(rmsg.type){
             case MSG_TYPE_URC_REGISTER:{
                 struct urc_register_msg *m = (struct urc_register_msg *)rmsg.data;
-                int assigned_id = -1;
                 if(m){
-                    assigned_id = _atc_urc_register(context, &m->entry);
-                    if(m->out_id) *m->out_id = assigned_id;
+                    for(size_t i = 0; i < m->count; i++){
+                        int assigned_id = _atc_urc_register(context, &m->entries[i]);
+                        if(m->out_ids) m->out_ids[i] = assigned_id;
+                    }
+                    if(m->done) m->done(context, m->out_ids, m->count, m->done_arg);
                 }
                 break;
             }
@@ -186,6 +374,28 @@ void extern_msg_handle(struct atc_context *context){
                 }
                 break;
             }
+            case MSG_TYPE_RESULT_CODE_REGISTER:{
+                struct result_code_msg *m = (struct result_code_msg *)rmsg.data;
+                if(m){
+                    enum atc_result result = _atc_result_code_register(context, m->code, m->result);
+                    if(m->out_result) *m->out_result = result;
+                }
+                break;
+            }
+            case MSG_TYPE_RESULT_CODE_UNREGISTER:{
+                struct result_code_msg *m = (struct result_code_msg *)rmsg.data;
+                if(m){
+                    enum atc_result result = _atc_result_code_unregister(context, m->code);
+                    if(m->out_result) *m->out_result = result;
+                }
+                break;
+            }
+            case MSG_TYPE_CMD_CANCEL:
+                cmd_cancel_handle(context, (struct atc_cmd *)rmsg.data);
+                break;
+            case MSG_TYPE_CMD_RELEASE:
+                cmd_release_handle(context, (struct atc_cmd *)rmsg.data);
+                break;
             default:
                 LOG_ERR("Unknown message type: %d", rmsg.type);
                 break;
@@ -3,27 +3,76 @@
 //遵循 Linux 内核风格，除了宏（Macros）和枚举常量（Enum constants）之外，所有东西都使用 snake_case（全小写 + 下划线）。
 
 #include <stddef.h>
+#include <stdbool.h>
 #include "../ring_buffer.h"
 #include "../slist.h"
-#include "../stack.h"
+#include "../trie.h"
 
 
-//串口接收环形缓冲区大小(Bytes)
+//串口接收环形缓冲区大小(Bytes)，必须为 2 的幂
 #define ATC_RX_BUFFER_SIZE 256
+#if (ATC_RX_BUFFER_SIZE < 2) || ((ATC_RX_BUFFER_SIZE & (ATC_RX_BUFFER_SIZE - 1)) != 0)
+    #error "ATC_RX_BUFFER_SIZE must be a power of 2"
+#endif
 //接收到单行的最大长度(Bytes)
 #define ATC_RX_LINE_MAX_SIZE 256
 //接收到响应的最大字节数
 #define ATC_RX_RESPONSE_MAX 512
-//prompt匹配堆栈最大深度
-#define ATC_PROMPT_STACK_MAX_DEPTH 20
+//各优先级发送队列的默认深度，可通过 atc_init_ex 按context配置
+#define ATC_SEND_QUEUE_DEPTH 6
+#define ATC_SEND_QUEUE_URGENT_DEPTH 2
+#define ATC_SEND_QUEUE_BACKGROUND_DEPTH 2
+//发送任务池默认槽数，可通过 atc_init_ex 按context配置。池空时退回 atc_malloc
+#define ATC_SEND_TASK_POOL_SIZE 8
+//发送任务槽内联存放的命令最大字节数，更长的命令数据使用 atc_malloc
+#define ATC_SEND_TASK_INLINE_SIZE 64
+//发送任务槽内联存放的提示符最大字节数，更长的提示符使用 atc_malloc
+#define ATC_SEND_TASK_INLINE_PROMPT_SIZE 16
+//同步调用等待信号量池的默认容量，可通过 atc_init_ex 按context配置
+#define ATC_WAIT_SEMAPHORE_POOL_SIZE 4
+//上传载荷每轮事件循环发送的最大字节数，也是拉取回调的缓冲区大小
+#define ATC_TX_CHUNK_SIZE 256
+//异步发送每次启动后等待完成通知的最长时间(ms)，超时后中止发送并以 ATC_TIMEOUT 结束命令
+#define ATC_TX_TIMEOUT_MS 1000
+//延迟URC队列槽数量（每个context，首次注册延迟处理函数时分配）
+#define ATC_URC_DEFER_QUEUE_DEPTH 8
+//延迟URC队列单槽最大字节数（含字符串结束符）
+#define ATC_URC_DEFER_SLOT_SIZE ATC_RX_LINE_MAX_SIZE
+//多行URC聚合缓冲区大小(Bytes)，每个context一个，超长的多行URC被丢弃
+#define ATC_URC_AGGREGATE_MAX_SIZE 512
+//限流暂存的单条URC最大字节数（含字符串结束符）
+#define ATC_URC_RATE_LINE_SIZE ATC_RX_LINE_MAX_SIZE
+//最终结果码（如"OK"、"+CME ERROR:"）的最大长度，包括字符串结束符
+#define ATC_RESULT_CODE_MAX_SIZE 32
+//结果缓存条目数（每个context，首次缓存结果时分配）
+#define ATC_RESULT_CACHE_SIZE 8
+//可缓存的命令最大字节数
+#define ATC_RESULT_CACHE_KEY_SIZE 32
+//可缓存的响应最大字节数，更长的响应不缓存
+#define ATC_RESULT_CACHE_RESPONSE_SIZE 128
 
 struct atc_context;
+struct urc_defer_slot;
+struct urc_handler_entry;
+struct send_task;
+struct timer_wheel;
+struct result_cache_entry;
+struct atc_cmd;
 
 enum atc_result{
     ATC_SUCCESS = 0,
     ATC_ERROR = -1,
     ATC_TIMEOUT = -2,
     ATC_HARDWARE_ERROR = -3,
+    ATC_CANCELLED = -4,     //命令被 atc_cmd_cancel 取消
+};
+
+//命令优先级，发送时总是先取最高优先级的非空队列
+enum atc_priority{
+    ATC_PRIORITY_NORMAL = 0,    //默认
+    ATC_PRIORITY_URGENT,        //紧急命令，如 AT+QISEND、关机
+    ATC_PRIORITY_BACKGROUND,    //后台轮询，如 AT+QIRD、AT+COPS=?
+    ATC_PRIORITY_COUNT,
 };
 
 //内存分配函数
@@ -63,7 +112,7 @@ typedef int (*atc_queue_recv_t)(void *queue, void *data, uint32_t timeout);
 
 //信号量函数
 typedef void *(*atc_semaphore_create_binary_t)(void);
-typedef int (*atc_semaphore_take_t)(void *sem, uint32_t timeout);
+typedef int (*atc_semaphore_take_t)(void *sem, uint32_t timeout);   //获取成功返回 0 (ATC_SUCCESS)，超时返回 -1 (ATC_ERROR)
 typedef int (*atc_semaphore_give_t)(void *sem);
 typedef void (*atc_semaphore_delete_t)(void *sem);
 typedef int (*atc_semaphore_give_isr_t)(void *sem);  // ISR 安全版本
@@ -77,6 +126,74 @@ typedef int (*atc_log_t)(const char *format, ...);
 //数据发送函数
 typedef enum atc_result (*atc_send_t)(struct atc_context *context, const char *data, size_t length);
 
+//异步数据发送函数（可选）：启动发送（如 DMA）后立即返回，发送完成后在中断中调用 atc_tx_complete_isr。
+//data 在完成通知前保持有效；启动失败时返回非 ATC_SUCCESS 且不通知完成
+typedef enum atc_result (*atc_send_start_t)(struct atc_context *context, const char *data, size_t length);
+//异步发送中止函数（可选）：停止 atc_send_start 启动且尚未完成的发送，返回后不再读取 data，也不再为该次发送调用 atc_tx_complete_isr
+typedef void (*atc_send_abort_t)(struct atc_context *context);
+
+//分段数据，用于 atc_sendv_* 和 atc_sendv 接口
+struct atc_iovec{
+    const char *data;
+    size_t length;
+};
+//分段数据发送函数（可选），按顺序发送所有段，如由 DMA 描述符链直接发送而不拼接。段数组可能含长度为0的段
+typedef enum atc_result (*atc_sendv_t)(struct atc_context *context, const struct atc_iovec *iov, size_t count);
+
+//延迟URC队列满（或超过处理函数的待派发上限）时的处理策略
+enum atc_urc_overflow_policy{
+    ATC_URC_OVERFLOW_DROP_NEWEST = 0,    //丢弃新到的URC
+    ATC_URC_OVERFLOW_OVERWRITE_OLDEST,   //覆盖最早未派发的URC
+};
+
+//延迟URC队列统计
+struct atc_urc_defer_stats{
+    uint32_t enqueued;      //入队数
+    uint32_t dispatched;    //已派发数
+    uint32_t dropped;       //因队列满/超过上限/过长而丢弃的新URC数
+    uint32_t overwritten;   //被新URC覆盖的旧URC数
+};
+
+//多行URC聚合方式：URC头部行之后的行归属于该URC，收齐后一次交给处理函数
+enum atc_urc_aggregate_mode{
+    ATC_URC_AGGREGATE_NONE = 0,             //单行URC
+    ATC_URC_AGGREGATE_LINES,                //头部之后固定行数（如 +CMT 的PDU行），不计空行
+    ATC_URC_AGGREGATE_UNTIL_BLANK,          //直到空行，空行不包含在内
+    ATC_URC_AGGREGATE_UNTIL_TERMINATOR,     //直到以终止串开头的行，终止行包含在内
+};
+
+//二进制负载URC：从头部解析随后的负载字节数，返回0表示没有负载。header 以'\0'结尾
+typedef size_t (*atc_urc_payload_length_t)(const char *header, size_t header_length);
+//二进制负载分块回调。data 直接指向接收环形缓冲区，仅在回调期间有效；offset 为该块在负载中的偏移，total 为负载总长度
+typedef void (*atc_urc_payload_handler_t)(struct atc_context *context, const char *header,
+                                            const char *data, size_t length, size_t offset, size_t total);
+
+//URC注册选项。所有字段为0即默认行为（在事件循环中直接调用处理函数）
+struct atc_urc_options{
+    //延迟派发：事件循环只复制URC行到预分配的队列，处理函数由 atc_urc_dispatch 在调用线程执行
+    bool deferred;
+    //该处理函数最多同时待派发的URC数，0表示只受队列深度 ATC_URC_DEFER_QUEUE_DEPTH 限制
+    uint16_t max_pending;
+    //超过限制时的处理策略
+    enum atc_urc_overflow_policy overflow_policy;
+    //二进制负载：非NULL时处理函数收到头部后，按返回的长度原样接收随后的字节交给 payload_handler，不作为行解析
+    atc_urc_payload_length_t payload_length;
+    atc_urc_payload_handler_t payload_handler;
+    //头部结束符：0或'\n'表示负载在头部行之后（如 +QIRD: <len>\r\n<data>）；
+    //其他字符表示负载紧跟在同一行的该字符之后（如 +IPD,<len>:<data> 使用':'），头部包含该字符
+    char payload_delimiter;
+    //多行聚合：处理函数收到的 line_data 为头部行及后续各行（含行结束符）的拼接，不能与二进制负载同时使用
+    enum atc_urc_aggregate_mode aggregate;
+    uint16_t aggregate_lines;               //ATC_URC_AGGREGATE_LINES 的行数
+    const char *aggregate_terminator;       //ATC_URC_AGGREGATE_UNTIL_TERMINATOR 的终止串，需保持有效直到反注册
+    //限流：两次交付的最小间隔（毫秒），0表示不限流。间隔内到达的URC暂存，间隔到期后由事件循环交付
+    uint32_t min_interval_ms;
+    //间隔内保留最近的URC条数，更早的被合并丢弃；0等同1，即只交付最新一条
+    uint16_t coalesce_keep;
+    //被合并丢弃的URC计数，由事件循环累加，需保持有效直到反注册。可以为 NULL
+    uint32_t *suppressed_count;
+};
+
 //底层接口
 struct atc_interface{
     //必须实现的函数
@@ -93,6 +210,12 @@ struct atc_interface{
     atc_semaphore_delete_t atc_semaphore_delete;
     atc_semaphore_give_isr_t atc_semaphore_give_isr;
     atc_get_tick_ms_t atc_get_tick_ms;
+    //可选函数，为 NULL 时分段命令逐段调用 atc_send
+    atc_sendv_t atc_sendv;
+    //可选函数，非 NULL 时所有发送都通过它异步进行（优先于 atc_send/atc_sendv），发送期间事件循环继续处理接收数据和定时器
+    atc_send_start_t atc_send_start;
+    //可选函数，异步发送超时或命令被取消时调用，为 NULL 时超时后直接放弃该次发送
+    atc_send_abort_t atc_send_abort;
 };
 
 
@@ -103,35 +226,170 @@ struct atc_context{
 
     //外部API消息队列
     void *external_api_queue;
-    //发送消息队列
-    void *send_queue;
-
-    //URC处理链表
+    //发送消息队列，按 enum atc_priority 索引，队列元素为发送任务指针
+    void *send_queue[ATC_PRIORITY_COUNT];
+    //排队名额，按 enum atc_priority 索引，容量为队列深度。提交时取走一个，命令离开等待发送链表时归还
+    void *send_queue_credit[ATC_PRIORITY_COUNT];
+    //事件循环从发送消息队列取出、等待发送的命令，按 enum atc_priority 索引的双向链表，排队超时可以直接摘除
+    //发送消息队列每轮全部取出，排队中的命令都已在链表中
+    struct send_task *send_pending_head[ATC_PRIORITY_COUNT];
+    struct send_task *send_pending_tail[ATC_PRIORITY_COUNT];
+    //发送任务池及空闲槽队列（元素为槽指针）
+    struct send_task *send_task_pool;
+    void *send_task_free_queue;
+    //同步调用等待信号量池（元素为信号量句柄）
+    void *wait_semaphore_pool;
+
+    //最终结果码前缀树，值为 struct result_code_entry
+    trie_t *result_code_trie;
+    //最近一次命令结束时匹配到的结果码，超时/硬件错误时为NULL
+    const char *final_result_code;
+
+    //URC处理链表（持有条目内存，用于ID管理）
     slist_t *urc_handler_list;
+    //URC前缀索引，值为同一前缀的处理函数链，注册/反注册时增量维护
+    trie_t *urc_prefix_trie;
+
+    //延迟URC队列，槽由 urc_defer_lock 保护
+    struct urc_defer_slot *urc_defer_slots;
+    void *urc_defer_lock;
+    void *urc_defer_semaphore;      //有URC入队时唤醒 atc_urc_dispatch
+    void *urc_defer_done_semaphore; //被反注册的处理函数执行完时唤醒 atc_urc_unregister
+    uint32_t urc_defer_seq;
+    struct atc_urc_defer_stats urc_defer_stats;
     int urc_next_id;             // URC ID分配计数器，初始值1
 
+    //URC二进制负载接收状态，urc_payload_received < urc_payload_total 时优先于命令状态接收原始字节
+    //头部保存在 line_buffer 中直到负载接收完成
+    atc_urc_payload_handler_t urc_payload_handler;
+    int urc_payload_id;
+    size_t urc_payload_total;
+    size_t urc_payload_received;
+    //多行URC聚合状态，urc_aggregate_entry 非NULL时后续行追加到聚合缓冲区
+    struct urc_handler_entry *urc_aggregate_entry;
+    uint16_t urc_aggregate_lines;   //ATC_URC_AGGREGATE_LINES 剩余行数
+    size_t urc_aggregate_length;
+    char urc_aggregate_buffer[ATC_URC_AGGREGATE_MAX_SIZE];
+
+    //异步发送：数据正在发送的任务，NULL表示空闲。每次 atc_send_start 对应一次 atc_tx_complete_isr
+    struct send_task *tx_task;
+    unsigned int tx_start_count;    //当前发送完成时 tx_complete_count 应达到的值
+    //由 atc_tx_complete_isr 递增（release），事件循环 acquire 读取，与接收环形缓冲区的写指针相同
+    ring_buffer_index_t tx_complete_count;
+
+    //结果缓存，条目由 result_cache_lock 保护。事件循环只尝试加锁，不等待调用者
+    struct result_cache_entry *result_cache;
+    void *result_cache_lock;
+    uint32_t result_cache_seq;
+
+    //时间轮：命令超时和URC限流间隔
+    struct timer_wheel *timer_wheel;
+
+    //同一行内携带负载的头部结束符位图，有此类URC注册时行扫描才检查这些字符
+    uint32_t urc_payload_delimiters[8];
+    bool urc_payload_inline;
+
     //当前发送任务
     struct send_task *current_send_task;
 
-    //行缓冲数组
+    //行缓冲数组，仅用于跨越环形缓冲区绕回点或分批到达的行
     char line_buffer[ATC_RX_LINE_MAX_SIZE];
     uint32_t line_buffer_index;
+    bool line_buffer_overflow;  //当前行超长，丢弃至行结束符
+
+    //上传载荷拉取缓冲区，同一时间只有当前命令使用
+    char tx_chunk[ATC_TX_CHUNK_SIZE];
 
     //响应缓冲区
     char response[ATC_RX_RESPONSE_MAX];
     size_t response_length; //当前响应数据长度
 
-    Stack *byte_stack; //用于prompt匹配
-
     void *wake_semaphore; //事件唤醒信号量
 };
 
 //URC处理函数类型定义
 typedef void (*atc_urc_handler_t)(struct atc_context *context, const char *line_data);
 
+//批量注册时的单个URC
+struct atc_urc_registration{
+    const char *prefix;
+    atc_urc_handler_t handler;
+    const struct atc_urc_options *options;  //可以为 NULL，注册消息创建时复制
+};
+
+//异步注册完成回调，在事件循环中调用。ids[i] 为 regs[i] 分配的ID，失败为 -1
+typedef void (*atc_urc_register_done_t)(struct atc_context *context, const int *ids, size_t count, void *arg);
+
 //AT命令发送返回的结果回调
 typedef void (*atc_cmd_response_handler_t)(struct atc_context *context, enum atc_result result, const char *response, size_t response_length);
 
+//最终结果码：以 code 开头的行表示命令结束，结果为 result
+struct atc_result_code{
+    const char *code;
+    enum atc_result result;
+};
+
+//命令附加选项。所有字段为0即默认行为
+struct atc_send_options{
+    //本条命令额外的最终结果码，优先于context的结果码表匹配。异步发送时需保持有效直到命令结束，通常为静态常量表
+    const struct atc_result_code *result_codes;
+    size_t result_code_count;
+    //命令优先级
+    enum atc_priority priority;
+    //排队超时（毫秒）：从提交开始计算，到期仍未发送的命令以 ATC_TIMEOUT 结束且不会发送。0表示不限制
+    uint32_t queue_timeout;
+    //等待提示符阶段的超时（毫秒），仅对带提示符的命令有效。设置后命令的 timeout 从匹配提示符开始计算。0表示不单独限制
+    uint32_t prompt_timeout;
+    //结果缓存有效期（毫秒）：非0时成功的结果按命令数据缓存，有效期内再次发送相同的命令直接返回缓存的响应，不经过串口。
+    //ATC_TIMEOUT_MAX 表示永久有效（IMEI、ICCID、固件版本等）。0表示不使用缓存。二进制接收的命令不缓存
+    uint32_t cache_ttl;
+};
+
+//context配置。所有字段为0即默认值
+struct atc_config{
+    //各优先级发送队列深度，按 enum atc_priority 索引，0表示使用 ATC_SEND_QUEUE_*DEPTH
+    uint16_t send_queue_depth[ATC_PRIORITY_COUNT];
+    //发送任务池槽数，0表示使用 ATC_SEND_TASK_POOL_SIZE
+    uint16_t send_task_pool_size;
+    //同步调用等待信号量池容量，0表示使用 ATC_WAIT_SEMAPHORE_POOL_SIZE
+    uint16_t wait_semaphore_pool_size;
+};
+
+//命令脚本中某一步失败时的处理策略
+enum atc_script_policy{
+    ATC_SCRIPT_ABORT_ON_ERROR = 0,      //中止，不再执行后续步骤
+    ATC_SCRIPT_CONTINUE_ON_ERROR,       //继续执行后续步骤
+};
+
+//命令脚本的一步
+struct atc_script_step{
+    const char *data;                       //命令数据，提交时复制
+    size_t length;
+    const struct atc_send_options *options; //附加选项，可以为 NULL
+    uint32_t timeout;                       //超时时间（毫秒），0表示不使用超时
+    //[OUT]本步结果及响应，均可以为 NULL，含义同 atc_send_sync。异步执行时需保持有效直到完成回调
+    enum atc_result *result;
+    char *response_buf;
+    size_t *response_length;
+};
+
+//命令脚本完成回调，在事件循环中调用。result 为第一个失败步骤的结果（全部成功为 ATC_SUCCESS），completed 为已执行的步骤数
+typedef void (*atc_script_done_t)(struct atc_context *context, enum atc_result result, size_t completed, void *arg);
+
+//上传载荷拉取回调：把载荷从 offset 开始的最多 size 字节写入 buf，返回写入的字节数，返回0表示出错
+typedef size_t (*atc_tx_pull_t)(struct atc_context *context, char *buf, size_t size, size_t offset, void *arg);
+
+//收到提示符后发送的上传载荷，data 与 pull 二选一
+struct atc_tx_payload{
+    const char *data;       //载荷数据，直接从该缓冲区分块发送不复制。异步发送时需保持有效直到命令结束
+    size_t length;          //载荷总长度，必须大于0
+    atc_tx_pull_t pull;     //data 为 NULL 时分块拉取载荷
+    void *arg;              //传给 pull 的用户参数
+};
+
+//二进制数据分块接收回调。data 直接指向接收环形缓冲区，仅在回调期间有效；offset 为该块在整个数据中的偏移
+typedef void (*atc_binary_chunk_handler_t)(struct atc_context *context, const char *data, size_t length, size_t offset);
+
 /* ==========================================================================
  * Section: Public API (Exposed)
  * Description: 供外部模块调用的接口
@@ -153,6 +411,15 @@ enum atc_result atc_interface_register(struct atc_interface *interface);
  */
 enum atc_result atc_init(struct atc_context *context);
 
+/**
+ * @brief 按配置初始化ATC上下文，其余同 atc_init
+ * 
+ * @param context ATC上下文
+ * @param config  配置，可以为 NULL
+ * @return enum atc_result 成功返回 ATC_SUCCESS，失败返回 ATC_ERROR
+ */
+enum atc_result atc_init_ex(struct atc_context *context, const struct atc_config *config);
+
 /**
  * @brief ATC处理函数，阻塞等待事件（数据到达/API调用/超时），内部死循环不返回
  *
@@ -171,9 +438,67 @@ void atc_process(struct atc_context *context);
  */
 int atc_urc_register(struct atc_context *context , const char *prefix, atc_urc_handler_t handler);
 
+/**
+ * @brief 带选项的URC注册函数（同步）
+ *        阻塞等待注册完成，返回分配的ID。禁止在URC回调内调用
+ *
+ * @param context ATC上下文
+ * @param prefix  URC前缀
+ * @param handler URC处理函数。设置了 options->payload_length 时以头部调用，可以为 NULL
+ * @param options 注册选项，可以为 NULL。二进制负载URC不能同时设置 deferred 或 min_interval_ms
+ * @return int    成功返回分配的ID(>0)，失败返回 -1
+ */
+int atc_urc_register_ex(struct atc_context *context, const char *prefix, atc_urc_handler_t handler, const struct atc_urc_options *options);
+
+/**
+ * @brief 批量URC注册函数（同步）
+ *        所有条目通过一条消息提交，只等待事件循环一次。禁止在URC回调内调用
+ *
+ * @param context ATC上下文
+ * @param regs    注册条目数组，任一条目参数非法时不注册任何条目
+ * @param count   条目数量
+ * @param ids     [OUT]分配的ID数组，长度为 count，注册失败的条目为 -1
+ * @return enum atc_result 全部注册成功返回 ATC_SUCCESS，否则返回 ATC_ERROR
+ */
+enum atc_result atc_urc_register_batch(struct atc_context *context, const struct atc_urc_registration *regs, size_t count, int *ids);
+
+/**
+ * @brief URC注册函数（异步）
+ *        投递后立即返回，不等待事件循环处理，可在URC回调内调用。条目参数在返回前已复制
+ *
+ * @param context ATC上下文
+ * @param regs    注册条目数组，任一条目参数非法时不注册任何条目
+ * @param count   条目数量
+ * @param done    注册完成回调，在事件循环中调用，可以为 NULL
+ * @param arg     传给 done 的用户参数
+ * @return enum atc_result 投递成功返回 ATC_SUCCESS，参数非法或队列满返回 ATC_ERROR
+ */
+enum atc_result atc_urc_register_async(struct atc_context *context, const struct atc_urc_registration *regs, size_t count,
+                                        atc_urc_register_done_t done, void *arg);
+
+/**
+ * @brief 派发延迟URC。等待直到有延迟URC入队或超时，然后按入队顺序执行所有待派发的处理函数
+ *        在用户的工作线程中循环调用；反注册返回后不会再执行该ID的处理函数
+ *
+ * @param context ATC上下文
+ * @param timeout 等待超时（毫秒），ATC_TIMEOUT_MAX表示永久等待，0表示不等待
+ * @return int    本次派发的URC数量，参数非法返回 -1
+ */
+int atc_urc_dispatch(struct atc_context *context, uint32_t timeout);
+
+/**
+ * @brief 获取延迟URC队列统计
+ *
+ * @param context ATC上下文
+ * @param stats   [OUT]统计数据
+ * @return enum atc_result 成功返回 ATC_SUCCESS，失败返回 ATC_ERROR
+ */
+enum atc_result atc_urc_defer_get_stats(struct atc_context *context, struct atc_urc_defer_stats *stats);
+
 /**
  * @brief URC反注册函数（同步）
  *        根据ID移除已注册的URC处理函数。禁止在URC回调内调用
+ *        延迟处理函数正在 atc_urc_dispatch 中执行时，等待其返回后才返回，之后不会再执行该处理函数
  *
  * @param context ATC上下文
  * @param id      要移除的URC处理函数ID（由 atc_urc_register 返回）
@@ -181,6 +506,35 @@ int atc_urc_register(struct atc_context *context , const char *prefix, atc_urc_h
  */
 enum atc_result atc_urc_unregister(struct atc_context *context, int id);
 
+/**
+ * @brief 注册最终结果码（同步）。以 code 开头的行将结束当前命令，已注册的 code 只更新结果。禁止在回调内调用
+ *        默认已注册 OK、ERROR、+CME ERROR:、+CMS ERROR:、NO CARRIER、NO DIALTONE、NO ANSWER、BUSY、SEND OK、SEND FAIL、ABORTED
+ *
+ * @param context ATC上下文
+ * @param code    结果码，长度小于 ATC_RESULT_CODE_MAX_SIZE
+ * @param result  匹配时命令的结果
+ * @return enum atc_result 成功返回 ATC_SUCCESS，失败返回 ATC_ERROR
+ */
+enum atc_result atc_result_code_register(struct atc_context *context, const char *code, enum atc_result result);
+
+/**
+ * @brief 反注册最终结果码（同步）。禁止在回调内调用
+ *
+ * @param context ATC上下文
+ * @param code    结果码
+ * @return enum atc_result 成功返回 ATC_SUCCESS，未找到返回 ATC_ERROR
+ */
+enum atc_result atc_result_code_unregister(struct atc_context *context, const char *code);
+
+/**
+ * @brief 获取结束当前命令的最终结果码（如"+CME ERROR:"），仅在命令响应回调内有效
+ *        完整的结果码行（含错误码等参数）位于响应数据末尾
+ *
+ * @param context ATC上下文
+ * @return const char* 匹配到的结果码，超时/硬件错误等非结果码结束时为 NULL
+ */
+const char *atc_final_result_code(struct atc_context *context);
+
 /**
  * @brief 异步发送AT命令
  * 
@@ -207,6 +561,174 @@ enum atc_result atc_send_async(struct atc_context *context, const char *data, si
 enum atc_result atc_send_sync(struct atc_context *context, const char *data, size_t length,
                                 enum atc_result *send_result, char *response_buf, size_t *response_length, uint32_t timeout);
 
+/**
+ * @brief 异步发送格式化的AT命令，如 atc_send_fmt_async(ctx, handler, 1000, "AT+QIRD=%d,%u\r\n", id, len)
+ *        命令直接格式化到发送任务池的槽内存储，不经过调用者的临时缓冲区，也不分配内存
+ * 
+ * @param context ATC上下文
+ * @param response_handler 命令响应处理回调
+ * @param timeout 超时时间（ms）。 0表示不使用超时
+ * @param fmt [IN]printf 格式字符串，格式化后的命令长度必须小于 ATC_SEND_TASK_INLINE_SIZE，否则返回 ATC_ERROR 而不截断
+ */
+enum atc_result atc_send_fmt_async(struct atc_context *context, atc_cmd_response_handler_t response_handler, uint32_t timeout, const char *fmt, ...);
+
+/**
+ * @brief 同步发送格式化的AT命令。禁止在URC回调内调用。send_result/response_buf/response_length/timeout 同 atc_send_sync
+ *        格式化后的命令长度必须小于 ATC_SEND_TASK_INLINE_SIZE，否则返回 ATC_ERROR 而不截断
+ */
+enum atc_result atc_send_fmt_sync(struct atc_context *context, enum atc_result *send_result, char *response_buf, size_t *response_length,
+                                    uint32_t timeout, const char *fmt, ...);
+
+/**
+ * @brief 带附加选项的异步发送AT命令
+ *        设置了 options->cache_ttl 且缓存命中时，在调用者线程中直接以缓存的响应调用 response_handler 后返回
+ * 
+ * @param context ATC上下文
+ * @param data 要发送的AT命令数据
+ * @param length 数据长度
+ * @param options 附加选项，可以为 NULL
+ * @param response_handler 命令响应处理回调
+ * @param timeout 超时时间（ms）。 0表示不使用超时
+ */
+enum atc_result atc_send_ex_async(struct atc_context *context, const char *data, size_t length, const struct atc_send_options *options,
+                                    atc_cmd_response_handler_t response_handler, uint32_t timeout);
+
+/**
+ * @brief 带附加选项的同步发送AT命令。禁止在URC回调内调用。参数同 atc_send_sync
+ *        设置了 options->cache_ttl 且缓存命中时，直接返回缓存的响应，不经过事件循环
+ * 
+ * @param options [IN]附加选项，可以为 NULL
+ */
+enum atc_result atc_send_ex_sync(struct atc_context *context, const char *data, size_t length, const struct atc_send_options *options,
+                                    enum atc_result *send_result, char *response_buf, size_t *response_length, uint32_t timeout);
+
+/**
+ * @brief 异步发送分段拼接的AT命令（如 头部+二进制数据+结尾），无需调用者先拼接到临时缓冲区
+ *        各段在返回前一次性复制到发送任务中（短命令存放在任务池槽内），返回后调用者即可释放
+ * 
+ * @param context ATC上下文
+ * @param iov [IN]段数组，长度为0的段被忽略
+ * @param count [IN]段数量
+ * @param options [IN]附加选项，可以为 NULL
+ * @param response_handler 命令响应处理回调
+ * @param timeout 超时时间（ms）。 0表示不使用超时
+ */
+enum atc_result atc_sendv_async(struct atc_context *context, const struct atc_iovec *iov, size_t count, const struct atc_send_options *options,
+                                    atc_cmd_response_handler_t response_handler, uint32_t timeout);
+
+/**
+ * @brief 异步发送分段拼接的AT命令，不复制段数组和各段数据，由 atc_sendv（未实现时逐段发送）直接发送。其余参数同 atc_sendv_async
+ *        适用于较大的二进制段，省去 atc_sendv_async 的拼接复制
+ * 
+ * @param iov [IN]段数组。段数组和各段数据需保持有效且不被修改，直到 response_handler 被调用（提交失败时立即可以释放）
+ * @param response_handler 命令响应处理回调，不能为 NULL，调用后段即可释放
+ */
+enum atc_result atc_sendv_async_nocopy(struct atc_context *context, const struct atc_iovec *iov, size_t count, const struct atc_send_options *options,
+                                    atc_cmd_response_handler_t response_handler, uint32_t timeout);
+
+/**
+ * @brief 同步发送分段拼接的AT命令。禁止在URC回调内调用。其余参数同 atc_send_sync
+ *        调用者阻塞到命令结束，段数组及各段数据不复制，由 atc_sendv（未实现时逐段 atc_send）直接发送
+ * 
+ * @param iov [IN]段数组，需保持有效直到函数返回
+ * @param count [IN]段数量
+ * @param options [IN]附加选项，可以为 NULL
+ */
+enum atc_result atc_sendv_sync(struct atc_context *context, const struct atc_iovec *iov, size_t count, const struct atc_send_options *options,
+                                    enum atc_result *send_result, char *response_buf, size_t *response_length, uint32_t timeout);
+
+/**
+ * @brief 提交AT命令并返回命令句柄，调用者可以取消、轮询或限时等待，一个线程可以同时持有多个（可跨context的）命令
+ *        句柄必须调用 atc_cmd_release 释放。设置了 options->cache_ttl 且缓存命中时，返回的句柄已经完成
+ *        句柄由 atc_malloc 分配，完成通知使用等待信号量池中的信号量。其他提交接口不提供句柄
+ * 
+ * @param context ATC上下文
+ * @param data [IN]要发送的数据，返回前已复制
+ * @param length [IN]数据长度
+ * @param options [IN]附加选项，可以为 NULL
+ * @param response_size [IN]保存在句柄中的响应最大字节，超过时截断，atc_cmd_response 返回截断后的长度。0表示不保存响应
+ * @param timeout [IN]命令超时时间（毫秒）。 0表示不使用超时
+ * @param cmd [OUT]命令句柄，失败时为 NULL
+ * @return enum atc_result 提交是否成功
+ */
+enum atc_result atc_send_cmd(struct atc_context *context, const char *data, size_t length, const struct atc_send_options *options,
+                                size_t response_size, uint32_t timeout, struct atc_cmd **cmd);
+
+/**
+ * @brief 检查命令是否结束，不阻塞
+ * 
+ * @param cmd 命令句柄
+ * @param result [OUT]命令结束时的结果，可以为 NULL
+ * @return true 命令已结束
+ */
+bool atc_cmd_poll(struct atc_cmd *cmd, enum atc_result *result);
+
+/**
+ * @brief 限时等待命令结束，只能由持有句柄的线程调用
+ * 
+ * @param cmd 命令句柄
+ * @param timeout [IN]等待时间（毫秒），ATC_TIMEOUT_MAX表示永久等待
+ * @param result [OUT]命令结束时的结果，可以为 NULL
+ * @return enum atc_result 命令已结束返回 ATC_SUCCESS，等待超时返回 ATC_TIMEOUT
+ */
+enum atc_result atc_cmd_wait(struct atc_cmd *cmd, uint32_t timeout, enum atc_result *result);
+
+/**
+ * @brief 获取已结束命令的响应（以'\0'结尾），命令未结束或未保存响应时返回 NULL。有效期到 atc_cmd_release 为止
+ */
+const char *atc_cmd_response(const struct atc_cmd *cmd, size_t *length);
+
+/**
+ * @brief 请求取消命令，不等待。排队中的命令不会发送；已发出的命令不再等待响应。均以 ATC_CANCELLED 结束
+ *        可在回调内调用。命令已结束时无操作
+ * 
+ * @return enum atc_result 请求是否投递成功，外部API队列满时返回 ATC_ERROR，可以重试
+ */
+enum atc_result atc_cmd_cancel(struct atc_cmd *cmd);
+
+/**
+ * @brief 释放命令句柄，之后不能再访问。命令未结束时继续执行，结束后由事件循环回收句柄
+ *        需要经外部API队列通知事件循环时，队列满则一直等待，因此不能在回调中释放未结束的命令
+ */
+void atc_cmd_release(struct atc_cmd *cmd);
+
+/**
+ * @brief 清除结果缓存，如模组重启或换卡后。可在任意线程调用
+ * 
+ * @param context ATC上下文
+ * @param data [IN]要清除的命令数据，NULL表示清除全部
+ * @param length [IN]命令数据长度
+ */
+void atc_result_cache_clear(struct atc_context *context, const char *data, size_t length);
+
+/**
+ * @brief 异步执行命令脚本。所有步骤一次提交，事件循环在上一步结束后立即发送下一步，不经过发送队列和线程切换
+ *
+ * @param context ATC上下文
+ * @param steps [IN]步骤数组，命令数据在返回前已复制
+ * @param count [IN]步骤数量
+ * @param policy [IN]步骤失败时的处理策略
+ * @param done [IN]脚本结束回调，可以为 NULL
+ * @param arg [IN]传给 done 的用户参数
+ * @return enum atc_result 提交是否成功
+ */
+enum atc_result atc_script_async(struct atc_context *context, const struct atc_script_step *steps, size_t count,
+                                    enum atc_script_policy policy, atc_script_done_t done, void *arg);
+
+/**
+ * @brief 同步执行命令脚本，阻塞到脚本结束。禁止在回调内调用
+ *
+ * @param context ATC上下文
+ * @param steps [IN]步骤数组
+ * @param count [IN]步骤数量
+ * @param policy [IN]步骤失败时的处理策略
+ * @param script_result [OUT]第一个失败步骤的结果，全部成功为 ATC_SUCCESS。可以为 NULL
+ * @param completed [OUT]已执行的步骤数。可以为 NULL
+ * @return enum atc_result 函数执行是否成功
+ */
+enum atc_result atc_script_sync(struct atc_context *context, const struct atc_script_step *steps, size_t count,
+                                    enum atc_script_policy policy, enum atc_result *script_result, size_t *completed);
+
 /**
  * @brief 异步发送命令，并在收到特定提示字符串后接收指定长度的二进制数据。收到特定提示字符串后接收满数据即返回成功
  * 
@@ -215,13 +737,60 @@ enum atc_result atc_send_sync(struct atc_context *context, const char *data, siz
  * @param data_len [IN]要发送的数据长度
  * @param prompt [IN]特定提示字符串
  * @param prompt_len [IN]特定提示字符串长度
- * @param recv_len [IN]要接收的二进制数据长度，如果不需要接收数据，为0即可。
+ * @param recv_len [IN]要接收的二进制数据长度，如果不需要接收数据，为0即可。数据暂存在context中，不能超过 ATC_RX_RESPONSE_MAX，
+ *                 更长的数据请使用 atc_send_with_prompt_binary_rx_stream_async
  * @param response_handler [IN]命令响应处理回调
  * @param timeout [IN]超时时间（毫秒）。 0表示不使用超时
  * @return enum atc_result 函数执行是否成功 
  */
 enum atc_result atc_send_with_prompt_binary_rx_async(struct atc_context *context, const char *data, size_t data_len, const char* prompt, size_t prompt_len, size_t recv_len , atc_cmd_response_handler_t response_handler , uint32_t timeout);
 
+/**
+ * @brief 异步流式版本，收到特定提示字符串后接收指定长度的二进制数据，数据直接从接收缓冲区分块交给回调，长度不受 ATC_RX_RESPONSE_MAX 限制
+ *        接收完成或失败后调用 response_handler，其中 response 为 NULL，response_length 为已接收的字节数
+ * 
+ * @param context ATC上下文
+ * @param data [IN]要发送的数据
+ * @param data_len [IN]要发送的数据长度
+ * @param prompt [IN]特定提示字符串
+ * @param prompt_len [IN]特定提示字符串长度
+ * @param recv_len [IN]要接收的二进制数据长度
+ * @param chunk_handler [IN]二进制数据分块回调
+ * @param response_handler [IN]命令响应处理回调
+ * @param timeout [IN]超时时间（毫秒）。 0表示不使用超时
+ * @return enum atc_result 函数执行是否成功 
+ */
+enum atc_result atc_send_with_prompt_binary_rx_stream_async(struct atc_context *context, const char *data, size_t data_len, const char* prompt, size_t prompt_len, size_t recv_len,
+                                atc_binary_chunk_handler_t chunk_handler, atc_cmd_response_handler_t response_handler, uint32_t timeout);
+
+/**
+ * @brief 异步发送命令，收到特定提示字符串（如 ">"）后分块发送上传载荷，再等待最终结果码（默认 SEND OK/SEND FAIL 等，
+ *        可通过 options->result_codes 指定本条命令的结束符）
+ *        每轮事件循环最多发送 ATC_TX_CHUNK_SIZE 字节，期间照常处理接收数据和URC
+ * 
+ * @param context ATC上下文
+ * @param data [IN]要发送的命令
+ * @param data_len [IN]命令长度
+ * @param prompt [IN]特定提示字符串
+ * @param prompt_len [IN]特定提示字符串长度
+ * @param payload [IN]上传载荷，结构体本身在返回前已复制
+ * @param options [IN]附加选项，可以为 NULL
+ * @param response_handler [IN]命令响应处理回调
+ * @param timeout [IN]整个过程的超时时间（毫秒）。 0表示不使用超时
+ * @return enum atc_result 函数执行是否成功 
+ */
+enum atc_result atc_send_with_prompt_payload_tx_async(struct atc_context *context, const char *data, size_t data_len, const char *prompt, size_t prompt_len,
+                                const struct atc_tx_payload *payload, const struct atc_send_options *options,
+                                atc_cmd_response_handler_t response_handler, uint32_t timeout);
+
+/**
+ * @brief 同步版本，收到特定提示字符串后分块发送上传载荷，阻塞到最终结果码。禁止在回调内调用
+ *        send_result/response_buf/response_length 含义同 atc_send_sync，其余参数同 atc_send_with_prompt_payload_tx_async
+ */
+enum atc_result atc_send_with_prompt_payload_tx_sync(struct atc_context *context, const char *data, size_t data_len, const char *prompt, size_t prompt_len,
+                                const struct atc_tx_payload *payload, const struct atc_send_options *options,
+                                enum atc_result *send_result, char *response_buf, size_t *response_length, uint32_t timeout);
+
 /**
  * @brief 同步版本，收到特定提示字符串后接收指定长度的二进制数据。收到特定提示字符串后接收满数据即返回成功
  * 
@@ -232,7 +801,7 @@ enum atc_result atc_send_with_prompt_binary_rx_async(struct atc_context *context
  * @param prompt_len [IN]特定提示字符串长度
  * @param recv_len [IN]要接收的二进制数据长度。如果不需要接收数据，为0即可。
  * @param send_result [OUT] 指示接收是否完成。可以为 NULL
- * @param response_buf [OUT] 接收到的二进制数据输出缓冲区。可以为 NULL
+ * @param response_buf [OUT] 接收到的二进制数据输出缓冲区，数据直接写入，长度不受 ATC_RX_RESPONSE_MAX 限制。可以为 NULL
  * @param response_length [IN/OUT] 响应缓冲区长度，输入时为外部缓冲区大小，输出时为实际二进制数据长度。仅在response_buf为NULL时可以为 NULL
  * @param timeout [IN]超时时间（毫秒）。 0表示不使用超时
  * @return enum atc_result 函数执行是否成功 
@@ -250,6 +819,34 @@ enum atc_result atc_send_with_prompt_binary_rx_sync(struct atc_context *context,
  */
 int atc_receive_data(struct atc_context *context, const char *data, size_t length);
 
+/**
+ * @brief 零拷贝接收：获取接收环形缓冲区中可直接写入的连续空间，供 DMA 等驱动直接填充。在接收中断中调用
+ *        与 atc_rx_commit 配对使用，且与 atc_receive_data 一样只能有一个生产者
+ * 
+ * @param context ATC上下文
+ * @param span [OUT] 连续可写空间的起始地址
+ * @param length [OUT] 连续可写的字节数。为0表示缓冲区已满；到达缓冲区末尾时需提交后再次获取绕回后的空间
+ * @return enum atc_result 成功返回 ATC_SUCCESS，参数非法返回 ATC_ERROR
+ */
+enum atc_result atc_rx_acquire_span(struct atc_context *context, char **span, size_t *length);
+
+/**
+ * @brief 零拷贝接收：提交已直接写入 atc_rx_acquire_span 所返回空间的数据，并唤醒处理线程。在接收中断中调用
+ * 
+ * @param context ATC上下文
+ * @param length 已写入的字节数
+ * @return int 实际提交的字节数
+ */
+int atc_rx_commit(struct atc_context *context, size_t length);
+
+/**
+ * @brief 异步发送完成通知：atc_send_start 启动的发送完成后调用，唤醒处理线程继续发送或结束命令。在发送完成中断中调用
+ *        每次成功的 atc_send_start 对应一次调用；ATC_TX_TIMEOUT_MS 内没有调用时中止该次发送，命令以 ATC_TIMEOUT 结束
+ * 
+ * @param context ATC上下文
+ */
+void atc_tx_complete_isr(struct atc_context *context);
+
 /* ==========================================================================
  * Section: Private / Internal
  * Description: 内部使用的辅助函数或结构体
@@ -0,0 +1,100 @@
+//prompt_matcher.c
+#include "interface.h"
+#include "prompt_matcher.h"
+#include <string.h>
+
+#define PROMPT_MATCHER_MALLOC g_atc_interface.atc_malloc
+#define PROMPT_MATCHER_FREE   g_atc_interface.atc_free
+
+int prompt_matcher_init(prompt_matcher_t *matcher, const char *prompt, size_t length)
+{
+    return prompt_matcher_init_buffer(matcher, prompt, length, NULL, 0);
+}
+
+int prompt_matcher_init_buffer(prompt_matcher_t *matcher, const char *prompt, size_t length, size_t *buffer, size_t words)
+{
+    if (matcher == NULL || prompt == NULL || length == 0) {
+        return 0;
+    }
+
+    // 失配表在前保证对齐，提示字符串副本紧随其后
+    size_t *fail = buffer;
+    bool owned = false;
+    if (fail == NULL || words < PROMPT_MATCHER_BUFFER_WORDS(length)) {
+        fail = (size_t *)PROMPT_MATCHER_MALLOC(length * sizeof(size_t) + length);
+        if (fail == NULL) {
+            return 0;
+        }
+        owned = true;
+    }
+    char *pattern = (char *)(fail + length);
+    memcpy(pattern, prompt, length);
+
+    // 计算失配表
+    fail[0] = 0;
+    size_t k = 0;
+    for (size_t i = 1; i < length; i++) {
+        while (k > 0 && pattern[i] != pattern[k]) {
+            k = fail[k - 1];
+        }
+        if (pattern[i] == pattern[k]) {
+            k++;
+        }
+        fail[i] = k;
+    }
+
+    matcher->pattern = pattern;
+    matcher->fail    = fail;
+    matcher->length  = length;
+    matcher->matched = 0;
+    matcher->owned   = owned;
+    return 1;
+}
+
+void prompt_matcher_deinit(prompt_matcher_t *matcher)
+{
+    if (matcher == NULL) return;
+
+    // 提示字符串与失配表是同一次分配
+    if (matcher->fail != NULL && matcher->owned) {
+        PROMPT_MATCHER_FREE(matcher->fail);
+    }
+    matcher->pattern = NULL;
+    matcher->fail    = NULL;
+    matcher->length  = 0;
+    matcher->matched = 0;
+    matcher->owned   = false;
+}
+
+void prompt_matcher_reset(prompt_matcher_t *matcher)
+{
+    if (matcher == NULL) return;
+    matcher->matched = 0;
+}
+
+size_t prompt_matcher_scan(prompt_matcher_t *matcher, const char *data, size_t length, bool *found)
+{
+    *found = false;
+    if (matcher == NULL || matcher->pattern == NULL || data == NULL) {
+        return length;
+    }
+
+    const char *pattern = matcher->pattern;
+    size_t matched = matcher->matched;
+    for (size_t i = 0; i < length; i++) {
+        // 失配时沿失配表回退，已匹配部分不需要重新比较
+        while (matched > 0 && data[i] != pattern[matched]) {
+            matched = matcher->fail[matched - 1];
+        }
+        if (data[i] == pattern[matched]) {
+            matched++;
+        }
+        if (matched == matcher->length) {
+            matcher->matched = 0;
+            *found = true;
+            return i + 1;
+        }
+    }
+    matcher->matched = matched;
+    return length;
+}
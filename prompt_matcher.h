@@ -0,0 +1,74 @@
+//prompt_matcher.h
+#ifndef PROMPT_MATCHER_H
+#define PROMPT_MATCHER_H
+
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * 提示符匹配器（KMP）
+ * 在字节流中查找固定提示字符串，跨多次输入保持匹配状态。
+ * 预先计算失配表，每个输入字节均摊 O(1)，不需要缓存历史字节，提示符长度不受限制。
+ */
+typedef struct {
+    char   *pattern;    /* 提示字符串副本 */
+    size_t *fail;       /* 失配表：fail[i] 为 pattern[0..i] 最长相等真前后缀长度 */
+    size_t  length;     /* 提示字符串长度 */
+    size_t  matched;    /* 当前已匹配的字节数 */
+    bool    owned;      /* 失配表与副本是否由匹配器分配 */
+} prompt_matcher_t;
+
+/* 长度为 length 的提示符所需的外部缓冲区大小（size_t 个数） */
+#define PROMPT_MATCHER_BUFFER_WORDS(length) ((length) + ((length) + sizeof(size_t) - 1) / sizeof(size_t))
+
+/**
+ * @brief 初始化匹配器，复制提示字符串并计算失配表（一次内存分配）
+ * @param matcher 匹配器
+ * @param prompt  提示字符串
+ * @param length  提示字符串长度，必须大于0
+ * @return 1 成功，0 失败（参数非法或内存不足）
+ */
+int prompt_matcher_init(prompt_matcher_t *matcher, const char *prompt, size_t length);
+
+/**
+ * @brief 初始化匹配器，优先使用调用者提供的缓冲区，不够时才分配内存
+ * @param matcher 匹配器
+ * @param prompt  提示字符串
+ * @param length  提示字符串长度，必须大于0
+ * @param buffer  外部缓冲区，生命周期不短于匹配器。可以为 NULL
+ * @param words   外部缓冲区大小（size_t 个数），需要 PROMPT_MATCHER_BUFFER_WORDS(length)
+ * @return 1 成功，0 失败（参数非法或内存不足）
+ */
+int prompt_matcher_init_buffer(prompt_matcher_t *matcher, const char *prompt, size_t length, size_t *buffer, size_t words);
+
+/**
+ * @brief 释放匹配器内存
+ * @param matcher 匹配器
+ */
+void prompt_matcher_deinit(prompt_matcher_t *matcher);
+
+/**
+ * @brief 复位匹配状态
+ * @param matcher 匹配器
+ */
+void prompt_matcher_reset(prompt_matcher_t *matcher);
+
+/**
+ * @brief 输入一段数据继续匹配，匹配成功时立即停止
+ * @param matcher 匹配器
+ * @param data    输入数据
+ * @param length  输入数据长度
+ * @param found   输出是否匹配成功
+ * @return 已消费的字节数。匹配成功时为提示符最后一个字节之后的位置，否则为 length
+ */
+size_t prompt_matcher_scan(prompt_matcher_t *matcher, const char *data, size_t length, bool *found);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PROMPT_MATCHER_H */
@@ -1,30 +1,25 @@
 #include "recv_data_handle.h"
 #include "log.h"
 #include "urc_handle.h"
+#include "result_code.h"
 #include <string.h>
 #include "send_msg_handle.h"
+#include "result_cache.h"
 #include <stdbool.h>
 #include <ctype.h>
-#include "stack.h"
 
-//命令结束符数组
-static const char *command_end_markers[] = {
-    "OK",
-    "ERROR",
-    NULL
-};
-
-//响应缓冲区清空
+//响应缓冲区清空，只需复位长度并终止字符串，不必清零整个缓冲区
 void clear_response_buffer(struct atc_context *context){
-    memset(context->response, 0, sizeof(context->response));
     context->response_length = 0;
+    context->response[0] = '\0';
 }
-//推入数据到响应缓冲区
+//推入数据到响应缓冲区，按已知偏移追加，保留数据中的'\0'
 static void push_to_response_buffer(struct atc_context *context, const char *line_data ,size_t length){
     size_t current_length = context->response_length;
-    if(current_length + length < ATC_RX_RESPONSE_MAX){
-        strncat(context->response, line_data, length);
+    if(current_length + length < ATC_RX_RESPONSE_MAX){   //保留一个字节给字符串结束符
+        memcpy(&context->response[current_length], line_data, length);
         context->response_length += length;
+        context->response[context->response_length] = '\0';
     }
     else{
         LOG_ERR("Response buffer overflow, cannot push more data");
@@ -33,65 +28,97 @@ static void push_to_response_buffer(struct atc_context *context, const char *lin
 
 //命令结束处理函数
 void command_end_handle(struct atc_context *context, enum atc_result result){
+    struct send_task *next = NULL;
+    //数据仍在异步发送，DMA 可能还在读取任务或调用者的缓冲区，发送完成后再结束。看门狗限制等待时间
+    if(context->current_send_task != NULL && context->current_send_task == context->tx_task){
+        if(!context->current_send_task->end_pending){
+            context->current_send_task->end_pending = true;
+            context->current_send_task->end_result = result;
+            send_tx_watchdog_arm(context, context->current_send_task);
+        }
+        return;
+    }
     if(context->current_send_task != NULL){
         LOG_DEBUG("Response result: %d", result);
         //打印所有响应
         if(context->response_length > 0 && context->current_send_task->status != SEND_TASK_STATUS_BINARY)
-            LOG_DEBUG("response:\r\n%s", context->response);
-        //调用响应处理回调
+            LOG_DEBUG("response:\r\n%.*s", (int)context->response_length, context->response);
+        //调用响应处理回调。二进制数据已直接写入调用者缓冲区或交给分块回调时，不经过context->response
+        const char *response = context->response;
+        size_t response_length = context->response_length;
+        struct send_task *task = context->current_send_task;
+        if(task->status == SEND_TASK_STATUS_BINARY && task->chunk_handler){
+            response = NULL;
+            response_length = task->recv_count;
+        }
+        else if(task->status == SEND_TASK_STATUS_BINARY && task->sync_response_buf){
+            response = task->sync_response_buf;
+            response_length = task->recv_count;
+        }
+        //成功的结果写入缓存。同步分段命令没有拼接后的命令数据，二进制数据的长度可能超过实际保存的字节，均不缓存
+        if(result == ATC_SUCCESS && task->cache_ttl != 0 && task->data != NULL && response != NULL
+            && task->status != SEND_TASK_STATUS_BINARY){
+            result_cache_store(context, task->data, task->length, response, response_length, task->cache_ttl);
+        }
         if(context->current_send_task->response_handler){
-            context->current_send_task->response_handler(context, result, context->response, context->response_length);
+            context->current_send_task->response_handler(context, result, response, response_length);
         }
         else{
             LOG_WARN("No response handler for current send task");
         }
-        //释放当前发送任务内存
-        if(context->current_send_task->data){
-            g_atc_interface.atc_free(context->current_send_task->data);
-            context->current_send_task->data = NULL;
-        }
-        if(context->current_send_task->prompt){
-            g_atc_interface.atc_free(context->current_send_task->prompt);
-            context->current_send_task->prompt = NULL;
-        }
-        g_atc_interface.atc_free(context->current_send_task);
+        //命令脚本：取出下一步，脚本结束时调用完成回调
+        next = send_script_step_end(context, task, result);
+        //停止超时并释放当前发送任务内存
+        timer_stop(context, &task->deadline);
+        send_task_free(context, task);
         context->current_send_task = NULL;
     }
+    context->final_result_code = NULL;
     //清除响应缓冲区
     clear_response_buffer(context);
-    //清空堆栈
-    stack_clear(context->byte_stack, NULL);
+    //立即发送脚本的下一步，不等待事件循环的下一轮
+    if(next != NULL){
+        context->current_send_task = next;
+        send_task_start(context);
+    }
 }
 
 //普通行处理
 static void normal_line_handle(struct atc_context *context, const char *line_data ,size_t length){
     LOG_TRACE;
+    //命令已结束、只等异步发送完成，之后的行不再属于它，与命令结束后到达的行一样丢弃
+    if(context->current_send_task != NULL && context->current_send_task->end_pending){
+        return;
+    }
     //推入响应缓冲区
     push_to_response_buffer(context, line_data, length);
-    //检查最新一行是否为命令结束符
-    for(int i = 0; command_end_markers[i] != NULL; i++){
-        size_t marker_length = strlen(command_end_markers[i]);
-        if(length >= marker_length && strncmp(line_data, command_end_markers[i], marker_length) == 0){
-            //命令结束符匹配，处理命令结束
-            bool is_ok = (strcmp(command_end_markers[i], "OK") == 0);
-            command_end_handle(context, is_ok ? ATC_SUCCESS : ATC_ERROR);
-            break;
-        }
+    //检查最新一行是否为最终结果码，一次前缀树下行完成分类
+    enum atc_result result;
+    const char *code = result_code_match(context, context->current_send_task, line_data, length, &result);
+    if(code != NULL){
+        //最终结果码匹配，处理命令结束
+        LOG_DEBUG("Final result code matched: %s", code);
+        context->final_result_code = code;
+        command_end_handle(context, result);
     }
 }
 
-//行处理函数,行包含\r\n
+//行处理函数,行包含\r\n。line_data 不保证以'\0'结尾
 static void line_handle(struct atc_context *context, const char *line_data ,size_t length){
     if(line_data == NULL){
         return;
     }
-    LOG_DEBUG("Received line: %s", line_data);
+    LOG_DEBUG("Received line: %.*s", (int)length, line_data);
+    //多行URC的后续行（包括空行）归属于该URC，不参与分类
+    if(urc_aggregate_line_handle(context, line_data, length)){
+        return;
+    }
     if(length <= 2){
         //空行，忽略
         return;
     }
     //URC行匹配及处理
-    bool is_urc = urc_line_handle(context, line_data);
+    bool is_urc = urc_line_handle(context, line_data, length);
 
     if(is_urc == false){
         //非URC行处理
@@ -99,138 +126,240 @@ static void line_handle(struct atc_context *context, const char *line_data ,size
     }
 }
 
-//对新接收的字节进行行处理
-static void byte_line_handle(struct atc_context *context, unsigned char byte){
-    //放到行缓冲区
-    if(context->line_buffer_index < ATC_RX_LINE_MAX_SIZE - 1){  //保留一个字节给字符串结束符
-        context->line_buffer[context->line_buffer_index] = (char)byte;
-        context->line_buffer_index++;
-        //检查是否为行结束符
-        if(byte == '\n'){
-            //行结束，处理该行数据
+//追加数据到行缓冲区，超长时置溢出标志并丢弃多余部分
+static void line_buffer_append(struct atc_context *context, const char *data, size_t length){
+    size_t space = ATC_RX_LINE_MAX_SIZE - 1 - context->line_buffer_index;   //保留一个字节给字符串结束符
+    if(length > space){
+        if(!context->line_buffer_overflow){
+            LOG_WARN("Line buffer overflow, discarding data");
+        }
+        context->line_buffer_overflow = true;
+        length = space;
+    }
+    memcpy(&context->line_buffer[context->line_buffer_index], data, length);
+    context->line_buffer_index += length;
+}
+
+//在行结束符之前查找同一行内负载的头部结束符，匹配到负载URC时返回已消费的头部字节数，否则返回0
+static size_t span_payload_header_handle(struct atc_context *context, const char *data, size_t length){
+    for(size_t i = 0; i < length; i++){
+        unsigned char c = (unsigned char)data[i];
+        if((context->urc_payload_delimiters[c >> 5] & (1u << (c & 31))) == 0){
+            continue;
+        }
+        size_t header_length = context->line_buffer_index + i + 1;
+        if(header_length >= ATC_RX_LINE_MAX_SIZE){
+            return 0;
+        }
+        const char *header = data;
+        if(context->line_buffer_index != 0){
+            //头部前半段已在行缓冲区，拼接后匹配；未匹配时这些字节会随行数据再次追加到同一位置
+            memcpy(&context->line_buffer[context->line_buffer_index], data, i + 1);
+            header = context->line_buffer;
+        }
+        if(urc_payload_header_handle(context, header, header_length)){
+            context->line_buffer_index = 0;
+            return i + 1;
+        }
+    }
+    return 0;
+}
+
+//行接收状态：在连续可读数据中查找行结束符，返回已消费的字节数。每次最多处理一行，以便行处理后任务状态变化时重新分发
+static size_t span_line_handle(struct atc_context *context, const char *data, size_t length){
+    //memchr 通常为按字(word)扫描的实现，比逐字节判断快得多
+    const char *end = memchr(data, '\n', length);
+    size_t used = end ? (size_t)(end - data) + 1 : length;
+
+    if(context->urc_payload_inline && !context->line_buffer_overflow){
+        //注册了同一行内携带负载的URC（如 +IPD,<len>:<data>），负载不能当作行数据
+        size_t header_used = span_payload_header_handle(context, data, used);
+        if(header_used > 0){
+            return header_used;
+        }
+    }
+
+    if(end != NULL && context->line_buffer_index == 0 && !context->line_buffer_overflow){
+        //整行位于连续区间内，直接在环形缓冲区上处理，无需复制
+        if(used < ATC_RX_LINE_MAX_SIZE){
+            line_handle(context, data, used);
+        }
+        else{
+            LOG_WARN("Line buffer overflow, discarding data");
+        }
+        return used;
+    }
+
+    //行跨越绕回点或尚未接收完整，暂存到行缓冲区
+    line_buffer_append(context, data, used);
+    if(end != NULL){
+        if(!context->line_buffer_overflow){
             context->line_buffer[context->line_buffer_index] = '\0'; //添加字符串结束符
             line_handle(context, context->line_buffer, context->line_buffer_index);
-            context->line_buffer_index = 0; //重置行缓冲区索引
         }
+        context->line_buffer_index = 0; //重置行缓冲区索引
+        context->line_buffer_overflow = false;
     }
-    else{
-        //行缓冲区满，丢弃数据
-        LOG_WARN("Line buffer overflow, discarding data");
-    }
-}
-//对新接收的字节进行提示符匹配处理
-static void byte_prompt_handle(struct atc_context *context, unsigned char byte){
-    //新字节推入堆栈
-    if(!stack_push_overwrite(context->byte_stack, (void*)(uintptr_t)byte, NULL)){
-        LOG_ERR("Failed to push byte to stack, stack full");
-    }
-    //检查堆栈顶前n个元素和prompt是否匹配
-    for(int i = 0; i < context->current_send_task->prompt_len; i++){
-        void *stack_byte = stack_peek_at(context->byte_stack, i);
-        if(stack_byte == NULL || (unsigned char)(uintptr_t)stack_byte != (unsigned char)context->current_send_task->prompt[context->current_send_task->prompt_len - 1 - i]){
-            //不匹配，继续等待
-            break;
-        }
-        if(i == context->current_send_task->prompt_len - 1){
-            //完全匹配，接收后续数据
-            stack_clear(context->byte_stack, NULL); //清空堆栈
-            if(context->current_send_task->need_recv_len!=0){
-                clear_response_buffer(context); //清空响应缓冲区，准备接收新数据
-                context->current_send_task->status = SEND_TASK_STATUS_BINARY; //设置任务状态为二进制数据接收中
-                LOG_DEBUG("Prompt matched, start receiving binary data");
-            }
-            else{
-                //不需要接收数据，直接调用响应处理回调
-                LOG_DEBUG("Prompt matched, no binary data to need receive");
-                command_end_handle(context, ATC_SUCCESS);
-            }
-            
+    return used;
+}
+//提示符匹配状态：用预编译的匹配器扫描整段数据，返回已消费的字节数
+static size_t span_prompt_handle(struct atc_context *context, const char *data, size_t length){
+    struct send_task *task = context->current_send_task;
+    bool found;
+    size_t used = prompt_matcher_scan(&task->prompt, data, length, &found);
+    if(found){
+        //完全匹配，发送上传载荷或接收后续数据
+        if(task->tx_length != 0){
+            task->status = SEND_TASK_STATUS_PAYLOAD_TX; //由事件循环分块发送
+            LOG_DEBUG("Prompt matched, start sending payload");
+        }
+        else if(task->need_recv_len!=0){
+            clear_response_buffer(context); //清空响应缓冲区，准备接收新数据
+            task->status = SEND_TASK_STATUS_BINARY; //设置任务状态为二进制数据接收中
+            LOG_DEBUG("Prompt matched, start receiving binary data");
+        }
+        else{
+            //不需要接收数据，直接调用响应处理回调
+            LOG_DEBUG("Prompt matched, no binary data to need receive");
+            command_end_handle(context, ATC_SUCCESS);
+            return used;
+        }
+        //设置了提示符阶段超时时，数据阶段的超时从匹配提示符开始计算
+        if(task->prompt_timeout != 0){
+            task->timestamp = _atc_time_get();
+            send_task_deadline_arm(context, task);
         }
     }
+    return used;
 }
-//对新接收的字节进行二进制数据处理
-static void byte_binary_handle(struct atc_context *context, unsigned char byte){
-    //接收二进制数据
-    struct send_task *current_send_task = context->current_send_task;
-    if(context->response_length < ATC_RX_RESPONSE_MAX){
-        context->response[context->response_length] = (char)byte;
-        context->response_length++;
-        //检查是否接收完成
-        if(context->response_length >= current_send_task->need_recv_len){
-            //接收完成，调用响应处理回调
-            LOG_DEBUG("Binary data received, length: %zu", context->response_length);
-            command_end_handle(context, ATC_SUCCESS);
+//二进制数据接收状态：整段直接交给分块回调或写入目标缓冲区，返回已消费的字节数
+static size_t span_binary_handle(struct atc_context *context, const char *data, size_t length){
+    struct send_task *task = context->current_send_task;
+    size_t remain = task->need_recv_len - task->recv_count;
+    if(remain == 0){
+        //已接收完成，命令结束被推迟到异步发送完成之后，后续数据按行处理
+        return span_line_handle(context, data, length);
+    }
+    size_t used = (length < remain) ? length : remain;
+
+    if(task->chunk_handler){
+        //零拷贝：数据直接从环形缓冲区交给回调
+        task->chunk_handler(context, data, used, task->recv_count);
+    }
+    else if(task->sync_response_buf){
+        //同步发送：直接写入调用者缓冲区，超出部分丢弃
+        size_t capacity = *(task->sync_response_length);
+        if(task->recv_count < capacity){
+            size_t copy_length = (used < capacity - task->recv_count) ? used : capacity - task->recv_count;
+            memcpy(&task->sync_response_buf[task->recv_count], data, copy_length);
         }
     }
-    else{
-        LOG_ERR("Response buffer overflow while receiving binary data");
+    else if(task->semaphore == NULL){
+        //异步发送：暂存到响应缓冲区，长度在提交时已检查
+        size_t space = ATC_RX_RESPONSE_MAX - context->response_length;
+        size_t copy_length = (used < space) ? used : space;
+        memcpy(&context->response[context->response_length], data, copy_length);
+        context->response_length += copy_length;
+        if(copy_length < used){
+            LOG_ERR("Response buffer overflow while receiving binary data");
+        }
     }
+    task->recv_count += used;
+
+    //检查是否接收完成
+    if(task->recv_count >= task->need_recv_len){
+        //接收完成，调用响应处理回调
+        LOG_DEBUG("Binary data received, length: %zu", task->recv_count);
+        command_end_handle(context, ATC_SUCCESS);
+    }
+    return used;
+}
+
+//按当前任务状态处理一段连续数据，返回已消费的字节数
+static size_t span_handle(struct atc_context *context, const char *data, size_t length){
+    //URC二进制负载可能插入在任何命令状态之间，优先接收
+    if(context->urc_payload_received < context->urc_payload_total){
+        return urc_payload_handle(context, data, length);
+    }
+    struct send_task *task = context->current_send_task;
+    //没有发送任务、任务处于行接收/载荷发送状态或已结束（等待异步发送完成），正常行处理
+    if(task == NULL || task->end_pending || task->status == SEND_TASK_STATUS_LINE_RECV || task->status == SEND_TASK_STATUS_PAYLOAD_TX){
+        return span_line_handle(context, data, length);
+    }
+    //提示符匹配/二进制接收状态，状态变化后立即返回重新分发
+    if(task->status == SEND_TASK_STATUS_PROMPT){
+        return span_prompt_handle(context, data, length);
+    }
+    return span_binary_handle(context, data, length);
 }
 
 void recv_data_handle(struct atc_context *context){
-    //读取环形缓冲区数据
-    unsigned char byte;
-    while(ring_buffer_read(&context->rx_buffer, &byte)){
+    //直接在环形缓冲区的连续可读区间上解析，不逐字节出队
+    const unsigned char *span;
+    unsigned int count;
+    while((count = ring_buffer_read_span(&context->rx_buffer, &span)) > 0){
+        size_t used = span_handle(context, (const char *)span, count);
         //打印接收到的数据
 #if LOG_LEVEL >= LOG_LEVEL_DEBUG
         g_atc_interface.atc_log(DBG_NAME"[RECV]:");
-        if(isprint(byte)){
-            g_atc_interface.atc_log("%c", byte);
-        }
-        else{
-            g_atc_interface.atc_log("[0x%02X]", (unsigned char)byte);
-        }
-        g_atc_interface.atc_log("\r\n");
-#endif
-        //检查当前发送任务是否存在
-        if(context->current_send_task != NULL){
-            enum send_task_status status = context->current_send_task->status;
-            //检查当前任务状态
-            if(status == SEND_TASK_STATUS_LINE_RECV){
-                //当前任务处于行接收状态，正常行处理
-                byte_line_handle(context, byte);
-            }
-            else if(status == SEND_TASK_STATUS_PROMPT){
-                //当前任务处于提示符匹配状态，检查提示符匹配
-                byte_prompt_handle(context, byte);
+        for(size_t i = 0; i < used; i++){
+            if(isprint(span[i])){
+                g_atc_interface.atc_log("%c", span[i]);
             }
-            else if(status == SEND_TASK_STATUS_BINARY){
-                //当前任务处于二进制数据接收状态
-                byte_binary_handle(context, byte);
+            else{
+                g_atc_interface.atc_log("[0x%02X]", span[i]);
             }
-            
-
-        }
-        else{   //当前没有发送任务，正常行处理
-            byte_line_handle(context, byte);
         }
+        g_atc_interface.atc_log("\r\n");
+#endif
+        ring_buffer_read_commit(&context->rx_buffer, (unsigned int)used);
     }
 }
 
 int atc_receive_data(struct atc_context *context, const char *data, size_t length){
     if(!context || !data || length == 0)
         return 0;
-    int count=0;
-    for(size_t i = 0; i < length; i++){
-        if(!ring_buffer_write(&context->rx_buffer, (unsigned char)data[i])){
-            return count;
-        }
-        count++;
+    //整块写入，绕回处最多两次memcpy
+    int count = (int)ring_buffer_write_block(&context->rx_buffer, (const unsigned char *)data, (unsigned int)length);
+    if(count > 0){
+        //唤醒阻塞等待的处理线程。缓冲区写满时也要唤醒，否则消费者无法腾出空间
+        g_atc_interface.atc_semaphore_give_isr(context->wake_semaphore);
+    }
+    return count;
+}
+
+enum atc_result atc_rx_acquire_span(struct atc_context *context, char **span, size_t *length){
+    if(!context || !span || !length)
+        return ATC_ERROR;
+    unsigned char *ptr = NULL;
+    *length = ring_buffer_write_span(&context->rx_buffer, &ptr);
+    *span = (char *)ptr;
+    return ATC_SUCCESS;
+}
+
+int atc_rx_commit(struct atc_context *context, size_t length){
+    if(!context || length == 0)
+        return 0;
+    int count = (int)ring_buffer_write_commit(&context->rx_buffer, (unsigned int)length);
+    if(count > 0){
+        //唤醒阻塞等待的处理线程
+        g_atc_interface.atc_semaphore_give_isr(context->wake_semaphore);
     }
-    //唤醒阻塞等待的处理线程
-    g_atc_interface.atc_semaphore_give_isr(context->wake_semaphore);
     return count;
 }
 
+const char *atc_final_result_code(struct atc_context *context){
+    return context ? context->final_result_code : NULL;
+}
+
 enum atc_result recv_data_init(struct atc_context *context){
     int ret=ring_buffer_init(&context->rx_buffer, context->rx_buffer_data, sizeof(context->rx_buffer_data));
     if(ret==0){
         LOG_ERR("Failed to initialize ring buffer");
         return ATC_ERROR;
     }
-    context->byte_stack = stack_create(ATC_PROMPT_STACK_MAX_DEPTH);
-    if(context->byte_stack == NULL){
-        LOG_ERR("Failed to create byte stack");
+    if(result_code_init(context) != ATC_SUCCESS){
+        LOG_ERR("Failed to initialize result code table");
         return ATC_ERROR;
     }
     return ATC_SUCCESS;
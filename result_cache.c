@@ -0,0 +1,147 @@
+/**
+ * @Description: 命令结果缓存
+ *               按命令数据缓存成功命令的响应，有效期内相同的命令在调用者线程直接返回，
+ *               不经过事件循环和串口。条目在事件循环中写入，在调用者线程中读取，由 result_cache_lock 保护。
+ *               持锁期间只做有界的查找和复制；事件循环只尝试加锁，调用者持锁时放弃本次写入，不会阻塞在调用者之后
+ */
+
+#include "result_cache.h"
+#include "log.h"
+#include <string.h>
+
+static void result_cache_lock(struct atc_context *context){
+    g_atc_interface.atc_semaphore_take(context->result_cache_lock, ATC_TIMEOUT_MAX);
+}
+
+static bool result_cache_try_lock(struct atc_context *context){
+    return g_atc_interface.atc_semaphore_take(context->result_cache_lock, 0) == ATC_SUCCESS;
+}
+
+static void result_cache_unlock(struct atc_context *context){
+    g_atc_interface.atc_semaphore_give(context->result_cache_lock);
+}
+
+enum atc_result result_cache_init(struct atc_context *context){
+    //二值信号量作互斥锁使用，创建后先释放一次。条目在首次写入时分配
+    context->result_cache_lock = g_atc_interface.atc_semaphore_create_binary();
+    if(context->result_cache_lock == NULL){
+        LOG_ERR("Failed to create result cache lock");
+        return ATC_ERROR;
+    }
+    g_atc_interface.atc_semaphore_give(context->result_cache_lock);
+    return ATC_SUCCESS;
+}
+
+//查找有效的条目，调用前已加锁
+static struct result_cache_entry *result_cache_find(struct atc_context *context, const char *key, size_t key_length){
+    if(context->result_cache == NULL){
+        return NULL;
+    }
+    uint32_t now = _atc_time_get();
+    for(size_t i = 0; i < ATC_RESULT_CACHE_SIZE; i++){
+        struct result_cache_entry *entry = &context->result_cache[i];
+        if(!entry->valid || entry->key_length != key_length || memcmp(entry->key, key, key_length) != 0){
+            continue;
+        }
+        if(!entry->permanent && (int32_t)(entry->expires - now) <= 0){
+            //已过期，顺便清除
+            entry->valid = false;
+            return NULL;
+        }
+        return entry;
+    }
+    return NULL;
+}
+
+//在调用者线程中调用：命中时复制响应的前 size 字节到 response（可以为 NULL），response_length 返回缓存的响应总长度
+bool result_cache_lookup(struct atc_context *context, const char *key, size_t key_length,
+                            char *response, size_t size, size_t *response_length){
+    if(key_length > ATC_RESULT_CACHE_KEY_SIZE){
+        return false;
+    }
+    result_cache_lock(context);
+    struct result_cache_entry *entry = result_cache_find(context, key, key_length);
+    if(entry != NULL){
+        size_t copy_length = (entry->response_length < size) ? entry->response_length : size;
+        if(response != NULL && copy_length > 0){
+            memcpy(response, entry->response, copy_length);
+        }
+        *response_length = entry->response_length;
+    }
+    result_cache_unlock(context);
+    return entry != NULL;
+}
+
+//在事件循环中调用：写入命令的响应。ttl 超过 2^31 毫秒视为永久有效，命令或响应超出条目容量时不缓存
+void result_cache_store(struct atc_context *context, const char *key, size_t key_length,
+                            const char *response, size_t response_length, uint32_t ttl){
+    if(key_length > ATC_RESULT_CACHE_KEY_SIZE || response_length > ATC_RESULT_CACHE_RESPONSE_SIZE){
+        LOG_DEBUG("Result too long to cache:%.*s", (int)key_length, key);
+        return;
+    }
+    //条目只由事件循环分配，不加锁读取指针
+    struct result_cache_entry *entries = NULL;
+    if(context->result_cache == NULL){
+        size_t size = sizeof(struct result_cache_entry) * ATC_RESULT_CACHE_SIZE;
+        entries = g_atc_interface.atc_malloc(size);
+        if(entries == NULL){
+            LOG_ERR("Failed to allocate memory for result cache");
+            return;
+        }
+        memset(entries, 0, size);
+    }
+    //调用者正在查询或清除时不等待，下次执行该命令时再缓存
+    if(!result_cache_try_lock(context)){
+        LOG_DEBUG("Result cache busy, skip:%.*s", (int)key_length, key);
+        if(entries != NULL){
+            g_atc_interface.atc_free(entries);
+        }
+        return;
+    }
+    if(entries != NULL){
+        context->result_cache = entries;
+    }
+    //同一命令覆盖原条目，否则使用空闲条目，都没有时替换最早写入的条目
+    struct result_cache_entry *target = result_cache_find(context, key, key_length);
+    for(size_t i = 0; target == NULL && i < ATC_RESULT_CACHE_SIZE; i++){
+        if(!context->result_cache[i].valid){
+            target = &context->result_cache[i];
+        }
+    }
+    if(target == NULL){
+        target = &context->result_cache[0];
+        for(size_t i = 1; i < ATC_RESULT_CACHE_SIZE; i++){
+            if((int32_t)(context->result_cache[i].seq - target->seq) < 0){
+                target = &context->result_cache[i];
+            }
+        }
+    }
+    target->valid = true;
+    target->permanent = ttl > INT32_MAX;
+    target->expires = _atc_time_get() + ttl;
+    target->seq = context->result_cache_seq++;
+    target->key_length = key_length;
+    memcpy(target->key, key, key_length);
+    target->response_length = response_length;
+    if(response_length > 0){
+        memcpy(target->response, response, response_length);
+    }
+    result_cache_unlock(context);
+}
+
+//清除缓存：data 为 NULL 时清除全部条目，否则只清除该命令的条目
+void atc_result_cache_clear(struct atc_context *context, const char *data, size_t length){
+    if(context == NULL || context->result_cache_lock == NULL){
+        return;
+    }
+    result_cache_lock(context);
+    if(context->result_cache != NULL){
+        for(size_t i = 0; i < ATC_RESULT_CACHE_SIZE; i++){
+            struct result_cache_entry *entry = &context->result_cache[i];
+            if(data == NULL || (entry->key_length == length && memcmp(entry->key, data, length) == 0)){
+                entry->valid = false;
+            }
+        }
+    }
+    result_cache_unlock(context);
+}
@@ -0,0 +1,23 @@
+#ifndef RESULT_CACHE_H
+#define RESULT_CACHE_H
+#include "include/ATCortex.h"
+
+//结果缓存条目
+struct result_cache_entry{
+    bool valid;
+    bool permanent;                 //永久有效，不检查 expires
+    uint32_t expires;               //到期时刻（毫秒tick）
+    uint32_t seq;                   //写入序号，缓存满时替换最早写入的条目
+    size_t key_length;
+    char key[ATC_RESULT_CACHE_KEY_SIZE];
+    size_t response_length;
+    char response[ATC_RESULT_CACHE_RESPONSE_SIZE];
+};
+
+enum atc_result result_cache_init(struct atc_context *context);
+bool result_cache_lookup(struct atc_context *context, const char *key, size_t key_length,
+                            char *response, size_t size, size_t *response_length);
+void result_cache_store(struct atc_context *context, const char *key, size_t key_length,
+                            const char *response, size_t response_length, uint32_t ttl);
+
+#endif // RESULT_CACHE_H
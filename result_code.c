@@ -0,0 +1,99 @@
+/**
+ * @Description: 最终结果码（命令结束符）匹配模块
+ */
+
+#include "result_code.h"
+#include "send_msg_handle.h"
+#include "log.h"
+#include <string.h>
+
+//默认的最终结果码
+static const struct atc_result_code default_result_codes[] = {
+    {"OK",          ATC_SUCCESS},
+    {"ERROR",       ATC_ERROR},
+    {"+CME ERROR:", ATC_ERROR},
+    {"+CMS ERROR:", ATC_ERROR},
+    {"NO CARRIER",  ATC_ERROR},
+    {"NO DIALTONE", ATC_ERROR},
+    {"NO ANSWER",   ATC_ERROR},
+    {"BUSY",        ATC_ERROR},
+    {"SEND OK",     ATC_SUCCESS},
+    {"SEND FAIL",   ATC_ERROR},
+    {"ABORTED",     ATC_ERROR},
+};
+
+static void result_code_free(void *data){
+    if(data) g_atc_interface.atc_free(data);
+}
+
+enum atc_result result_code_init(struct atc_context *context){
+    if(context->result_code_trie != NULL){
+        return ATC_SUCCESS;
+    }
+    context->result_code_trie = trie_create(result_code_free);
+    if(context->result_code_trie == NULL){
+        LOG_ERR("Failed to create result code trie");
+        return ATC_ERROR;
+    }
+    for(size_t i = 0; i < sizeof(default_result_codes) / sizeof(default_result_codes[0]); i++){
+        if(_atc_result_code_register(context, default_result_codes[i].code, default_result_codes[i].result) != ATC_SUCCESS){
+            return ATC_ERROR;
+        }
+    }
+    return ATC_SUCCESS;
+}
+
+enum atc_result _atc_result_code_register(struct atc_context *context, const char *code, enum atc_result result){
+    size_t length = strlen(code);
+    //已注册则只更新结果
+    struct result_code_entry *entry = trie_find(context->result_code_trie, code, length);
+    if(entry != NULL){
+        entry->result = result;
+        return ATC_SUCCESS;
+    }
+    entry = g_atc_interface.atc_malloc(sizeof(struct result_code_entry));
+    if(entry == NULL){
+        LOG_ERR("Failed to allocate memory for result_code_entry");
+        return ATC_ERROR;
+    }
+    memcpy(entry->code, code, length + 1);
+    entry->result = result;
+    if(trie_insert(context->result_code_trie, code, length, entry) != 0){
+        LOG_ERR("Failed to insert result code %s", code);
+        g_atc_interface.atc_free(entry);
+        return ATC_ERROR;
+    }
+    LOG_DEBUG("register result code:%s, result:%d", code, result);
+    return ATC_SUCCESS;
+}
+
+enum atc_result _atc_result_code_unregister(struct atc_context *context, const char *code){
+    struct result_code_entry *entry = trie_remove(context->result_code_trie, code, strlen(code));
+    if(entry == NULL){
+        LOG_WARN("Result code %s not found", code);
+        return ATC_ERROR;
+    }
+    g_atc_interface.atc_free(entry);
+    return ATC_SUCCESS;
+}
+
+//检查行是否以最终结果码开头。先匹配命令自带的结果码，再在context的前缀树中一次下行找最长匹配
+//返回匹配到的结果码字符串，未匹配返回NULL
+const char *result_code_match(struct atc_context *context, const struct send_task *task, const char *line_data, size_t length, enum atc_result *result){
+    if(task != NULL){
+        for(size_t i = 0; i < task->result_code_count; i++){
+            const struct atc_result_code *code = &task->result_codes[i];
+            size_t code_length = strlen(code->code);
+            if(length >= code_length && memcmp(line_data, code->code, code_length) == 0){
+                *result = code->result;
+                return code->code;
+            }
+        }
+    }
+    struct result_code_entry *entry = trie_longest_prefix(context->result_code_trie, line_data, length, NULL);
+    if(entry != NULL){
+        *result = entry->result;
+        return entry->code;
+    }
+    return NULL;
+}
@@ -0,0 +1,16 @@
+#ifndef RESULT_CODE_H
+#define RESULT_CODE_H
+#include "include/ATCortex.h"
+
+struct send_task;
+
+struct result_code_entry{
+    char code[ATC_RESULT_CODE_MAX_SIZE];
+    enum atc_result result;
+};
+enum atc_result result_code_init(struct atc_context *context);
+enum atc_result _atc_result_code_register(struct atc_context *context, const char *code, enum atc_result result);
+enum atc_result _atc_result_code_unregister(struct atc_context *context, const char *code);
+const char *result_code_match(struct atc_context *context, const struct send_task *task, const char *line_data, size_t length, enum atc_result *result);
+
+#endif // RESULT_CODE_H
@@ -1,4 +1,38 @@
 #include "ring_buffer.h"
+#include <string.h>
+
+/*
+ * 读写指针访问宏，仅本文件使用
+ * 对端指针用 acquire 读取，保证看到对端发布前写入/读出的数据；
+ * 本端指针用 release 发布，保证数据拷贝完成后才对对端可见。
+ */
+#if RING_BUFFER_USE_C11_ATOMICS
+    #define RB_LOAD_RELAXED(p)      atomic_load_explicit((p), memory_order_relaxed)
+    #define RB_LOAD_ACQUIRE(p)      atomic_load_explicit((p), memory_order_acquire)
+    #define RB_STORE_RELEASE(p, v)  atomic_store_explicit((p), (v), memory_order_release)
+#else
+    #ifndef RING_BUFFER_BARRIER
+        #if defined(__GNUC__)
+            #define RING_BUFFER_BARRIER() __sync_synchronize()
+        #else
+            #error "C11 atomics unavailable, please define RING_BUFFER_BARRIER() for this compiler"
+        #endif
+    #endif
+    static inline unsigned int rb_load_acquire(const ring_buffer_index_t *p)
+    {
+        unsigned int v = *p;
+        RING_BUFFER_BARRIER();
+        return v;
+    }
+    static inline void rb_store_release(ring_buffer_index_t *p, unsigned int v)
+    {
+        RING_BUFFER_BARRIER();
+        *p = v;
+    }
+    #define RB_LOAD_RELAXED(p)      (*(p))
+    #define RB_LOAD_ACQUIRE(p)      rb_load_acquire(p)
+    #define RB_STORE_RELEASE(p, v)  rb_store_release((p), (v))
+#endif
 
 // 为了判空，需要包含 NULL 定义，通常在 stddef.h 或 stdio.h
 #ifndef NULL
@@ -10,20 +44,21 @@
  *
  * @param handle   环形缓冲区控制句柄
  * @param buffer   外部提供的内存区域
- * @param capacity 内存区域的大小
+ * @param capacity 内存区域的大小，必须为 2 的幂
  * @return int     1 表示成功, 0 表示失败
  */
 int ring_buffer_init(ring_buffer_t *handle, unsigned char *buffer, unsigned int capacity)
 {
-    // 至少需要2个单元才能区分空/满状态 (因为有一个单元总是保留为空)
-    if (handle == NULL || buffer == NULL || capacity < 2) {
+    // 容量必须为 2 的幂，下标才能用掩码计算
+    if (handle == NULL || buffer == NULL || capacity < 2 || (capacity & (capacity - 1)) != 0) {
         return 0;
     }
 
-    handle->buffer      = buffer;
-    handle->capacity    = capacity;
-    handle->read_index  = 0;
-    handle->write_index = 0;
+    handle->buffer   = buffer;
+    handle->capacity = capacity;
+    handle->mask     = capacity - 1;
+    RB_STORE_RELEASE(&handle->read_index, 0);
+    RB_STORE_RELEASE(&handle->write_index, 0);
 
     return 1;
 }
@@ -38,10 +73,11 @@ void ring_buffer_deinit(ring_buffer_t *handle)
     if (handle == NULL) return;
 
     // 因为内存是外部传入的，这里不进行 free，只将指针置空以防误用
-    handle->buffer      = NULL;
-    handle->capacity    = 0;
-    handle->read_index  = 0;
-    handle->write_index = 0;
+    handle->buffer   = NULL;
+    handle->capacity = 0;
+    handle->mask     = 0;
+    RB_STORE_RELEASE(&handle->read_index, 0);
+    RB_STORE_RELEASE(&handle->write_index, 0);
 }
 
 /**
@@ -57,17 +93,17 @@ int ring_buffer_write(ring_buffer_t *handle, unsigned char data)
         return 0;
     }
 
-    // 计算下一个写指针的位置
-    unsigned int next_write = (handle->write_index + 1) % handle->capacity;
+    unsigned int write_index = RB_LOAD_RELAXED(&handle->write_index);
+    unsigned int read_index  = RB_LOAD_ACQUIRE(&handle->read_index);
 
-    // 判断缓冲区是否已满。如果下一个写指针追上了读指针，则表示缓冲区已满。
-    if (next_write == handle->read_index) {
+    // 自由递增的指针之差即为数据量，等于容量表示已满
+    if (write_index - read_index >= handle->capacity) {
         return 0; // 缓冲区满
     }
 
-    // 写入数据并更新写指针
-    handle->buffer[handle->write_index] = data;
-    handle->write_index = next_write;
+    // 写入数据后再发布写指针
+    handle->buffer[write_index & handle->mask] = data;
+    RB_STORE_RELEASE(&handle->write_index, write_index + 1);
 
     return 1;
 }
@@ -85,18 +121,205 @@ int ring_buffer_read(ring_buffer_t *handle, unsigned char *data)
         return 0;
     }
 
-    // 判断缓冲区是否为空。如果读写指针相等，则表示缓冲区为空。
-    if (handle->read_index == handle->write_index) {
+    unsigned int read_index  = RB_LOAD_RELAXED(&handle->read_index);
+    unsigned int write_index = RB_LOAD_ACQUIRE(&handle->write_index);
+
+    // 读写指针相等表示缓冲区为空
+    if (read_index == write_index) {
         return 0; // 缓冲区空
     }
 
-    // 读取数据并更新读指针
-    *data = handle->buffer[handle->read_index];
-    handle->read_index = (handle->read_index + 1) % handle->capacity;
+    // 读取数据后再释放空间给生产者
+    *data = handle->buffer[read_index & handle->mask];
+    RB_STORE_RELEASE(&handle->read_index, read_index + 1);
 
     return 1;
 }
 
+/**
+ * @brief 【生产者调用】向缓冲区批量写入数据
+ *
+ * @param handle 环形缓冲区控制句柄
+ * @param data   要写入的数据
+ * @param length 要写入的长度
+ * @return unsigned int 实际写入的字节数
+ */
+unsigned int ring_buffer_write_block(ring_buffer_t *handle, const unsigned char *data, unsigned int length)
+{
+    if (handle == NULL || handle->buffer == NULL || data == NULL) {
+        return 0;
+    }
+
+    unsigned int write_index = RB_LOAD_RELAXED(&handle->write_index);
+    unsigned int read_index  = RB_LOAD_ACQUIRE(&handle->read_index);
+
+    // 剩余空间
+    unsigned int free_space = handle->capacity - (write_index - read_index);
+    if (length > free_space) {
+        length = free_space;
+    }
+    if (length == 0) {
+        return 0;
+    }
+
+    // 第一段：写指针到缓冲区末尾；第二段：绕回后从头开始
+    unsigned int offset = write_index & handle->mask;
+    unsigned int first  = handle->capacity - offset;
+    if (first > length) {
+        first = length;
+    }
+    memcpy(&handle->buffer[offset], data, first);
+    if (length > first) {
+        memcpy(&handle->buffer[0], data + first, length - first);
+    }
+
+    // 数据写完后再发布写指针
+    RB_STORE_RELEASE(&handle->write_index, write_index + length);
+
+    return length;
+}
+
+/**
+ * @brief 【消费者调用】从缓冲区批量读取数据
+ *
+ * @param handle 环形缓冲区控制句柄
+ * @param data   用于接收数据的缓冲区
+ * @param length 接收缓冲区大小
+ * @return unsigned int 实际读取的字节数
+ */
+unsigned int ring_buffer_read_block(ring_buffer_t *handle, unsigned char *data, unsigned int length)
+{
+    if (handle == NULL || handle->buffer == NULL || data == NULL) {
+        return 0;
+    }
+
+    unsigned int read_index  = RB_LOAD_RELAXED(&handle->read_index);
+    unsigned int write_index = RB_LOAD_ACQUIRE(&handle->write_index);
+
+    unsigned int count = write_index - read_index;
+    if (length > count) {
+        length = count;
+    }
+    if (length == 0) {
+        return 0;
+    }
+
+    unsigned int offset = read_index & handle->mask;
+    unsigned int first  = handle->capacity - offset;
+    if (first > length) {
+        first = length;
+    }
+    memcpy(data, &handle->buffer[offset], first);
+    if (length > first) {
+        memcpy(data + first, &handle->buffer[0], length - first);
+    }
+
+    // 数据取走后再释放空间给生产者
+    RB_STORE_RELEASE(&handle->read_index, read_index + length);
+
+    return length;
+}
+
+/**
+ * @brief 【生产者调用】获取可直接写入的连续空间
+ *
+ * @param handle 环形缓冲区控制句柄
+ * @param span   输出连续可写空间的起始地址
+ * @return unsigned int 连续可写的字节数
+ */
+unsigned int ring_buffer_write_span(ring_buffer_t *handle, unsigned char **span)
+{
+    if (handle == NULL || handle->buffer == NULL || span == NULL) {
+        return 0;
+    }
+
+    unsigned int write_index = RB_LOAD_RELAXED(&handle->write_index);
+    unsigned int read_index  = RB_LOAD_ACQUIRE(&handle->read_index);
+
+    unsigned int free_space = handle->capacity - (write_index - read_index);
+    unsigned int offset     = write_index & handle->mask;
+    unsigned int contiguous = handle->capacity - offset;
+
+    *span = &handle->buffer[offset];
+    return (free_space < contiguous) ? free_space : contiguous;
+}
+
+/**
+ * @brief 【生产者调用】提交直接写入的数据
+ *
+ * @param handle 环形缓冲区控制句柄
+ * @param length 已写入的字节数
+ * @return unsigned int 实际提交的字节数
+ */
+unsigned int ring_buffer_write_commit(ring_buffer_t *handle, unsigned int length)
+{
+    if (handle == NULL || handle->buffer == NULL) {
+        return 0;
+    }
+
+    unsigned int write_index = RB_LOAD_RELAXED(&handle->write_index);
+    unsigned int read_index  = RB_LOAD_ACQUIRE(&handle->read_index);
+
+    // 不允许越过读指针，防止覆盖未读数据
+    unsigned int free_space = handle->capacity - (write_index - read_index);
+    if (length > free_space) {
+        length = free_space;
+    }
+
+    RB_STORE_RELEASE(&handle->write_index, write_index + length);
+    return length;
+}
+
+/**
+ * @brief 【消费者调用】获取可直接读取的连续数据
+ *
+ * @param handle 环形缓冲区控制句柄
+ * @param span   输出连续可读数据的起始地址
+ * @return unsigned int 连续可读的字节数
+ */
+unsigned int ring_buffer_read_span(ring_buffer_t *handle, const unsigned char **span)
+{
+    if (handle == NULL || handle->buffer == NULL || span == NULL) {
+        return 0;
+    }
+
+    unsigned int read_index  = RB_LOAD_RELAXED(&handle->read_index);
+    unsigned int write_index = RB_LOAD_ACQUIRE(&handle->write_index);
+
+    unsigned int count      = write_index - read_index;
+    unsigned int offset     = read_index & handle->mask;
+    unsigned int contiguous = handle->capacity - offset;
+
+    *span = &handle->buffer[offset];
+    return (count < contiguous) ? count : contiguous;
+}
+
+/**
+ * @brief 【消费者调用】消费已处理的数据
+ *
+ * @param handle 环形缓冲区控制句柄
+ * @param length 已处理的字节数
+ * @return unsigned int 实际消费的字节数
+ */
+unsigned int ring_buffer_read_commit(ring_buffer_t *handle, unsigned int length)
+{
+    if (handle == NULL || handle->buffer == NULL) {
+        return 0;
+    }
+
+    unsigned int read_index  = RB_LOAD_RELAXED(&handle->read_index);
+    unsigned int write_index = RB_LOAD_ACQUIRE(&handle->write_index);
+
+    // 不允许越过写指针
+    unsigned int count = write_index - read_index;
+    if (length > count) {
+        length = count;
+    }
+
+    RB_STORE_RELEASE(&handle->read_index, read_index + length);
+    return length;
+}
+
 /**
  * @brief 获取缓冲区中当前的数据量
  * @note 在并发环境下，返回的值可能在你拿到它的时候就已经过时了。
@@ -110,6 +333,29 @@ int ring_buffer_data_count(const ring_buffer_t *handle)
         return -1;
     }
 
-    // 动态计算数据量
-    return (handle->write_index - handle->read_index + handle->capacity) % handle->capacity;
-}
\ No newline at end of file
+    // 自由递增的指针直接相减，无符号回绕自动正确
+    unsigned int read_index  = RB_LOAD_ACQUIRE((ring_buffer_index_t *)&handle->read_index);
+    unsigned int write_index = RB_LOAD_ACQUIRE((ring_buffer_index_t *)&handle->write_index);
+    return (int)(write_index - read_index);
+}
+
+/**
+ * @brief 单写者计数器加一并以 release 语义发布
+ *
+ * @param counter 计数器指针
+ */
+void ring_buffer_counter_increment(ring_buffer_index_t *counter)
+{
+    RB_STORE_RELEASE(counter, RB_LOAD_RELAXED(counter) + 1);
+}
+
+/**
+ * @brief 以 acquire 语义读取单写者计数器
+ *
+ * @param counter 计数器指针
+ * @return unsigned int 计数器当前值
+ */
+unsigned int ring_buffer_counter_load(const ring_buffer_index_t *counter)
+{
+    return RB_LOAD_ACQUIRE((ring_buffer_index_t *)counter);
+}
@@ -9,20 +9,38 @@
 extern "C" {
 #endif
 
+/*
+ * 单生产者/单消费者（SPSC）无锁环形缓冲区
+ * - 生产者（如 UART ISR）只调用 write 系列，消费者（如 atc_process）只调用 read 系列，双方无需加锁
+ * - 容量必须为 2 的幂，读写指针自由递增，用掩码取下标，全程没有除法/取模
+ * - 支持 C11 atomics 时使用 acquire/release 内存序；否则退化为 volatile + RING_BUFFER_BARRIER()，
+ *   可在编译参数中自定义 -DRING_BUFFER_BARRIER()=xxx 注入屏障实现
+ */
+#if !defined(__cplusplus) && !defined(RING_BUFFER_NO_C11_ATOMICS) && !defined(__STDC_NO_ATOMICS__) \
+    && defined(__STDC_VERSION__) && (__STDC_VERSION__ >= 201112L)
+    #include <stdatomic.h>
+    #define RING_BUFFER_USE_C11_ATOMICS 1
+    typedef atomic_uint ring_buffer_index_t;
+#else
+    #define RING_BUFFER_USE_C11_ATOMICS 0
+    typedef volatile unsigned int ring_buffer_index_t;
+#endif
+
 /* 环形缓冲区控制句柄 */
 typedef struct {
     unsigned char *buffer;              /* 指向外部传入的数据缓冲区 */
-    unsigned int   capacity;            /* 缓冲区总容量（注意：采用“空一格”判满策略） */
-    volatile unsigned int read_index;   /* 读指针 */
-    volatile unsigned int write_index;  /* 写指针 */
+    unsigned int   capacity;            /* 缓冲区总容量，必须为 2 的幂，全部可用 */
+    unsigned int   mask;                /* capacity - 1，用于下标取模 */
+    ring_buffer_index_t read_index;     /* 读指针（自由递增，仅消费者修改） */
+    ring_buffer_index_t write_index;    /* 写指针（自由递增，仅生产者修改） */
 } ring_buffer_t;
 
 /**
  * @brief 初始化环形缓冲区（静态模式）
  * @param handle    句柄指针（控制块）
  * @param buffer    外部传入的缓冲区数组指针
- * @param capacity  buffer 数组的大小。实际可存放的最大字节数为 capacity-1。
- * @return 1 成功，0 失败（参数非法）
+ * @param capacity  buffer 数组的大小，必须为 2 的幂。实际可存放的最大字节数为 capacity。
+ * @return 1 成功，0 失败（参数非法或容量不是 2 的幂）
  */
 int ring_buffer_init(ring_buffer_t *handle, unsigned char *buffer, unsigned int capacity);
 
@@ -49,6 +67,60 @@ int ring_buffer_write(ring_buffer_t *handle, unsigned char data);
  */
 int ring_buffer_read(ring_buffer_t *handle, unsigned char *data);
 
+/**
+ * @brief 【生产者调用】向环形缓冲区批量写入数据
+ * @note 绕回处最多拆成两次 memcpy，空间不足时只写入能容纳的部分
+ * @param handle 句柄指针
+ * @param data   待写入数据
+ * @param length 待写入长度
+ * @return 实际写入的字节数，0 表示满或未初始化
+ */
+unsigned int ring_buffer_write_block(ring_buffer_t *handle, const unsigned char *data, unsigned int length);
+
+/**
+ * @brief 【消费者调用】从环形缓冲区批量读取数据
+ * @note 绕回处最多拆成两次 memcpy
+ * @param handle 句柄指针
+ * @param data   输出缓冲区
+ * @param length 输出缓冲区大小
+ * @return 实际读取的字节数，0 表示空或未初始化
+ */
+unsigned int ring_buffer_read_block(ring_buffer_t *handle, unsigned char *data, unsigned int length);
+
+/**
+ * @brief 【生产者调用】获取当前可直接写入的连续空间（零拷贝写入）
+ * @note 只返回到缓冲区末尾为止的一段，绕回后的空间需在提交后再次获取
+ * @param handle 句柄指针
+ * @param span   输出连续可写空间的起始地址
+ * @return 连续可写的字节数，0 表示满或未初始化
+ */
+unsigned int ring_buffer_write_span(ring_buffer_t *handle, unsigned char **span);
+
+/**
+ * @brief 【生产者调用】提交已直接写入连续空间的数据，发布给消费者
+ * @param handle 句柄指针
+ * @param length 已写入的字节数，超出当前可写空间的部分会被截断
+ * @return 实际提交的字节数
+ */
+unsigned int ring_buffer_write_commit(ring_buffer_t *handle, unsigned int length);
+
+/**
+ * @brief 【消费者调用】获取当前可直接读取的连续数据（零拷贝读取，不移动读指针）
+ * @note 只返回到缓冲区末尾为止的一段，绕回后的数据需在消费后再次获取
+ * @param handle 句柄指针
+ * @param span   输出连续可读数据的起始地址
+ * @return 连续可读的字节数，0 表示空或未初始化
+ */
+unsigned int ring_buffer_read_span(ring_buffer_t *handle, const unsigned char **span);
+
+/**
+ * @brief 【消费者调用】消费已处理的数据，释放空间给生产者
+ * @param handle 句柄指针
+ * @param length 已处理的字节数，超出当前数据量的部分会被截断
+ * @return 实际消费的字节数
+ */
+unsigned int ring_buffer_read_commit(ring_buffer_t *handle, unsigned int length);
+
 /**
  * @brief 获取当前缓冲区的数据量
  * @param handle 句柄指针
@@ -56,6 +128,20 @@ int ring_buffer_read(ring_buffer_t *handle, unsigned char *data);
  */
 int ring_buffer_data_count(const ring_buffer_t *handle);
 
+/**
+ * @brief 【单写者调用】计数器加一并以 release 语义发布，可在 ISR 中调用
+ * @note 用于环形缓冲区之外的单写者计数器（如异步发送完成计数），保证加一前的写入对读者可见
+ * @param counter 计数器指针
+ */
+void ring_buffer_counter_increment(ring_buffer_index_t *counter);
+
+/**
+ * @brief 【读者调用】以 acquire 语义读取单写者计数器
+ * @param counter 计数器指针
+ * @return 计数器当前值
+ */
+unsigned int ring_buffer_counter_load(const ring_buffer_index_t *counter);
+
 #ifdef __cplusplus
 }
 #endif
@@ -10,113 +10,417 @@
 #include <stdio.h>
 #include <string.h>
 #include "recv_data_handle.h"
+#include "wait_pool.h"
+#include "result_cache.h"
 #include <ctype.h>
+#include <stdarg.h>
 
 static void sync_response_handler(struct atc_context *context, enum atc_result result, const char *response, size_t response_length){
+    struct send_task *task = context->current_send_task;
     //将结果和响应数据复制到上下文中
-    if(context->current_send_task->sync_send_result){
-        *(context->current_send_task->sync_send_result) = result;
+    if(task->sync_send_result){
+        *(task->sync_send_result) = result;
     }
-    if(response && response_length > 0 && context->current_send_task->sync_response_buf && context->current_send_task->sync_response_length){
+    if(task->sync_response_buf && task->sync_response_length){
         //计算最小复制长度，防止缓冲区溢出
-        size_t copy_length = (response_length < *(context->current_send_task->sync_response_length)) ? response_length : *(context->current_send_task->sync_response_length);
-        memcpy(context->current_send_task->sync_response_buf, response, copy_length);
-        *(context->current_send_task->sync_response_length) = copy_length;
+        size_t copy_length = (response_length < *(task->sync_response_length)) ? response_length : *(task->sync_response_length);
+        //二进制数据已直接写入调用者缓冲区，无需再复制
+        if(response && copy_length > 0 && response != task->sync_response_buf){
+            memcpy(task->sync_response_buf, response, copy_length);
+        }
+        *(task->sync_response_length) = response ? copy_length : 0;
     }
     //释放等待的信号量
-    if(context->current_send_task->semaphore){
-        g_atc_interface.atc_semaphore_give(context->current_send_task->semaphore);
+    if(task->semaphore){
+        g_atc_interface.atc_semaphore_give(task->semaphore);
     }
 }
 
+//命令脚本共享状态，脚本结束时释放
+struct send_script{
+    enum atc_script_policy policy;
+    enum atc_result result;     //第一个失败步骤的结果，全部成功为 ATC_SUCCESS
+    size_t completed;           //已结束的步骤数
+    atc_script_done_t done;
+    void *done_arg;
+};
 
-enum atc_result atc_send_sync(struct atc_context *context, const char *data, size_t length,
-                                enum atc_result *send_result, char *response_buf, size_t *response_length, uint32_t timeout){
+//从任务池取一个空闲槽并按原型初始化，池空时退回 atc_malloc
+static struct send_task *send_task_alloc(struct atc_context *context, const struct send_task *proto){
+    struct send_task *task = NULL;
+    if(context->send_task_free_queue != NULL
+        && g_atc_interface.atc_queue_recv(context->send_task_free_queue, &task, 0) == ATC_SUCCESS){
+        *task = *proto;
+        task->pooled = true;
+        return task;
+    }
+    task = g_atc_interface.atc_malloc(sizeof(struct send_task));
+    if(task == NULL){
+        LOG_ERR("Failed to allocate memory for send_task");
+        return NULL;
+    }
+    LOG_DEBUG("send_task pool empty, fallback to atc_malloc");
+    *task = *proto;
+    task->pooled = false;
+    return task;
+}
+
+//释放发送任务及其数据，池中的槽归还空闲队列。
+//可在调用者线程中调用，不访问时间轮：启动过 deadline 的任务由事件循环先停止定时器再释放
+void send_task_free(struct atc_context *context, struct send_task *task){
+    if(task->data && task->data != task->inline_data){
+        g_atc_interface.atc_free(task->data);
+    }
+    task->data = NULL;
+    prompt_matcher_deinit(&task->prompt);
+    if(task->pooled){
+        //空闲队列深度等于槽数，不会满
+        g_atc_interface.atc_queue_send(context->send_task_free_queue, &task, 0);
+    }
+    else{
+        g_atc_interface.atc_free(task);
+    }
+}
+
+//按原型创建发送任务：复制命令数据，预先编译提示符匹配器。短命令和提示符存放在槽内
+static struct send_task *send_task_create(struct atc_context *context, const struct send_task *proto,
+                                            const char *data, size_t length, const char *prompt, size_t prompt_len){
+    struct send_task *task = send_task_alloc(context, proto);
+    if(task == NULL){
+        return NULL;
+    }
+    if(task->iov != NULL){
+        //分段命令引用调用者的段，不复制
+        task->data = NULL;
+    }
+    else if(length <= ATC_SEND_TASK_INLINE_SIZE){
+        task->data = task->inline_data;
+    }
+    else{
+        task->data = g_atc_interface.atc_malloc(length);
+        if(task->data == NULL){
+            LOG_ERR("Failed to allocate memory for send_task data");
+            send_task_free(context, task);
+            return NULL;
+        }
+    }
+    //复制要发送的数据，data 为 NULL 时由调用者填充
+    if(task->data != NULL && data != NULL){
+        memcpy(task->data, data, length);
+    }
+    task->length = length;
+    task->timestamp = 0; //初始化时间戳
+    //0表示不使用超时
+    if(task->timeout == 0){
+        task->timeout = ATC_TIMEOUT_MAX;
+    }
+
+    //二进制接收相关：预先编译提示符匹配器
+    if(prompt != NULL){
+        if(!prompt_matcher_init_buffer(&task->prompt, prompt, prompt_len,
+                                        task->inline_prompt, sizeof(task->inline_prompt) / sizeof(size_t))){
+            LOG_ERR("Failed to allocate memory for send_task prompt");
+            send_task_free(context, task);
+            return NULL;
+        }
+        task->status = SEND_TASK_STATUS_PROMPT; //设置任务状态为提示符匹配中
+    }
+    return task;
+}
+
+//归还排队名额，唤醒等待名额的提交者
+static void send_task_credit_return(struct atc_context *context, struct send_task *task){
+    if(task->queue_credit){
+        uint8_t credit = 0;
+        task->queue_credit = false;
+        g_atc_interface.atc_queue_send(context->send_queue_credit[task->priority], &credit, 0);
+    }
+}
+
+//投递到对应优先级的“发送消息队列”并唤醒处理线程，失败时释放任务
+static enum atc_result send_task_submit(struct atc_context *context, struct send_task *task){
+    //排队超时从提交时刻开始计算
+    task->enqueue_time = _atc_time_get();
+    //先取排队名额，队列已满时在这里等待。持有名额的任务数不超过发送消息队列深度，投递不会失败
+    uint8_t credit;
+    enum atc_result ret = g_atc_interface.atc_queue_recv(context->send_queue_credit[task->priority], &credit, 1000);
+    if(ret == ATC_SUCCESS){
+        task->queue_credit = true;
+        ret = g_atc_interface.atc_queue_send(context->send_queue[task->priority], &task, 0);
+    }
+    if(ret != ATC_SUCCESS){
+        //发送失败，释放资源
+        send_task_credit_return(context, task);
+        send_task_free(context, task);
+        LOG_ERR("Failed to send message to send queue");
+        return ATC_ERROR;
+    }
+    //唤醒阻塞等待的处理线程
+    g_atc_interface.atc_semaphore_give(context->wake_semaphore);
+    return ATC_SUCCESS;
+}
+
+//按原型创建发送任务并投递
+static enum atc_result send_task_enqueue(struct atc_context *context, const struct send_task *proto,
+                                            const char *data, size_t length, const char *prompt, size_t prompt_len){
+    struct send_task *task = send_task_create(context, proto, data, length, prompt, prompt_len);
+    if(task == NULL){
+        return ATC_ERROR;
+    }
+    return send_task_submit(context, task);
+}
+
+//同步投递准备：检查信号量接口并获取等待信号量，任务创建失败时需调用 wait_semaphore_release 归还
+static enum atc_result send_task_wait_prepare(struct atc_context *context, struct send_task *proto){
     //检查信号量函数是否实现
     if(g_atc_interface.atc_semaphore_take == NULL || g_atc_interface.atc_semaphore_give == NULL 
         || g_atc_interface.atc_semaphore_create_binary == NULL || g_atc_interface.atc_semaphore_delete == NULL){
         LOG_ERR("Semaphore functions are not implemented");
         return ATC_ERROR;
     }
+    proto->response_handler = sync_response_handler;
+    //设置同步发送相关参数
+    proto->semaphore = wait_semaphore_acquire(context);
+    if(proto->semaphore == NULL){
+        LOG_ERR("Failed to create semaphore for sync send");
+        return ATC_ERROR;
+    }
+    return ATC_SUCCESS;
+}
+
+//投递已创建的同步任务并阻塞到命令结束，之后归还等待信号量
+static enum atc_result send_task_submit_wait(struct atc_context *context, struct send_task *task){
+    void *semaphore = task->semaphore;
+    if(send_task_submit(context, task) != ATC_SUCCESS){
+        wait_semaphore_release(context, semaphore);
+        return ATC_ERROR;
+    }
+    //等待发送完成或超时
+    g_atc_interface.atc_semaphore_take(semaphore, ATC_TIMEOUT_MAX);
+    //归还信号量
+    wait_semaphore_release(context, semaphore);
+    return ATC_SUCCESS;
+}
+
+//同步投递：创建等待信号量，投递后阻塞到命令结束
+static enum atc_result send_task_enqueue_wait(struct atc_context *context, struct send_task *proto,
+                                                const char *data, size_t length, const char *prompt, size_t prompt_len){
+    if(send_task_wait_prepare(context, proto) != ATC_SUCCESS){
+        return ATC_ERROR;
+    }
+    struct send_task *task = send_task_create(context, proto, data, length, prompt, prompt_len);
+    if(task == NULL){
+        wait_semaphore_release(context, proto->semaphore);
+        return ATC_ERROR;
+    }
+    return send_task_submit_wait(context, task);
+}
+
+//按原型创建发送任务，命令直接格式化到槽内存储，放不下时返回 NULL 而不截断
+static struct send_task *send_task_create_fmt(struct atc_context *context, const struct send_task *proto, const char *fmt, va_list args){
+    struct send_task *task = send_task_create(context, proto, NULL, ATC_SEND_TASK_INLINE_SIZE, NULL, 0);
+    if(task == NULL){
+        return NULL;
+    }
+    int length = vsnprintf(task->data, ATC_SEND_TASK_INLINE_SIZE, fmt, args);
+    if(length <= 0 || length >= ATC_SEND_TASK_INLINE_SIZE){
+        LOG_ERR("Formatted command length %d does not fit ATC_SEND_TASK_INLINE_SIZE", length);
+        send_task_free(context, task);
+        return NULL;
+    }
+    task->length = (size_t)length;
+    return task;
+}
+
+//将附加选项应用到发送任务
+static void send_task_apply_options(struct send_task *task, const struct atc_send_options *options){
+    if(options == NULL){
+        return;
+    }
+    task->result_codes = options->result_codes;
+    task->result_code_count = options->result_codes ? options->result_code_count : 0;
+    task->priority = (options->priority < ATC_PRIORITY_COUNT) ? options->priority : ATC_PRIORITY_NORMAL;
+    task->queue_timeout = options->queue_timeout;
+    task->prompt_timeout = options->prompt_timeout;
+    task->cache_ttl = options->cache_ttl;
+}
+
+enum atc_result atc_send_ex_sync(struct atc_context *context, const char *data, size_t length, const struct atc_send_options *options,
+                                    enum atc_result *send_result, char *response_buf, size_t *response_length, uint32_t timeout){
     //检查参数
     if(context == NULL || data == NULL || length == 0 || (response_buf != NULL && response_length == NULL) ){
         LOG_ERR("Invalid parameters");
         return ATC_ERROR;
     }
-    //0表示不使用超时
-    if(timeout == 0){
-        timeout = ATC_TIMEOUT_MAX;
+    //结果缓存命中时不经过事件循环
+    size_t cached_length;
+    if(options != NULL && options->cache_ttl != 0
+        && result_cache_lookup(context, data, length, response_buf, response_buf ? *response_length : 0, &cached_length)){
+        if(send_result){
+            *send_result = ATC_SUCCESS;
+        }
+        if(response_buf){
+            *response_length = (cached_length < *response_length) ? cached_length : *response_length;
+        }
+        return ATC_SUCCESS;
     }
-    //分配内存
     struct send_task task={0};
-    task.data = g_atc_interface.atc_malloc(length);
-    if(task.data == NULL){
-        LOG_ERR("Failed to allocate memory for send_task data");
+    send_task_apply_options(&task, options);
+    task.timeout = timeout;
+    task.sync_send_result = send_result;
+    task.sync_response_buf = response_buf;
+    task.sync_response_length = response_length;
+    return send_task_enqueue_wait(context, &task, data, length, NULL, 0);
+}
+enum atc_result atc_send_ex_async(struct atc_context *context, const char *data, size_t length, const struct atc_send_options *options,
+                                    atc_cmd_response_handler_t response_handler, uint32_t timeout){
+    if(context == NULL || data == NULL || length == 0){
         return ATC_ERROR;
     }
-    //复制要发送的数据
-    memcpy(task.data, data, length);
-    task.length = length;
-    task.response_handler = sync_response_handler;
+    //结果缓存命中时在调用者线程完成
+    char cached[ATC_RESULT_CACHE_RESPONSE_SIZE];
+    size_t cached_length;
+    if(options != NULL && options->cache_ttl != 0
+        && result_cache_lookup(context, data, length, cached, sizeof(cached), &cached_length)){
+        if(response_handler){
+            response_handler(context, ATC_SUCCESS, cached, cached_length);
+        }
+        return ATC_SUCCESS;
+    }
+    struct send_task task={0};
+    send_task_apply_options(&task, options);
+    task.response_handler = response_handler;
     task.timeout = timeout;
-    task.timestamp = 0; //初始化时间戳
-    //设置同步发送相关参数
-    task.semaphore = g_atc_interface.atc_semaphore_create_binary();
-    if(task.semaphore == NULL){
-        g_atc_interface.atc_free(task.data);
-        LOG_ERR("Failed to create semaphore for sync send");
+    return send_task_enqueue(context, &task, data, length, NULL, 0);
+}
+
+//计算分段命令总长度，段数组无效时返回0
+static size_t send_iov_length(const struct atc_iovec *iov, size_t count){
+    size_t total = 0;
+    for(size_t i = 0; i < count; i++){
+        if(iov[i].data == NULL && iov[i].length != 0){
+            return 0;
+        }
+        total += iov[i].length;
+    }
+    return total;
+}
+
+enum atc_result atc_sendv_async(struct atc_context *context, const struct atc_iovec *iov, size_t count, const struct atc_send_options *options,
+                                    atc_cmd_response_handler_t response_handler, uint32_t timeout){
+    size_t total = (context && iov) ? send_iov_length(iov, count) : 0;
+    if(total == 0){
+        LOG_ERR("Invalid parameters");
+        return ATC_ERROR;
+    }
+    struct send_task proto={0};
+    send_task_apply_options(&proto, options);
+    proto.response_handler = response_handler;
+    proto.timeout = timeout;
+    //异步发送时调用者不等待，各段一次性拼接到任务数据中
+    struct send_task *task = send_task_create(context, &proto, NULL, total, NULL, 0);
+    if(task == NULL){
         return ATC_ERROR;
     }
+    size_t offset = 0;
+    for(size_t i = 0; i < count; i++){
+        if(iov[i].length != 0){
+            memcpy(task->data + offset, iov[i].data, iov[i].length);
+            offset += iov[i].length;
+        }
+    }
+    return send_task_submit(context, task);
+}
+
+enum atc_result atc_sendv_async_nocopy(struct atc_context *context, const struct atc_iovec *iov, size_t count, const struct atc_send_options *options,
+                                    atc_cmd_response_handler_t response_handler, uint32_t timeout){
+    size_t total = (context && iov) ? send_iov_length(iov, count) : 0;
+    //响应回调是调用者得知段可以释放的唯一时机，必须提供
+    if(total == 0 || response_handler == NULL){
+        LOG_ERR("Invalid parameters");
+        return ATC_ERROR;
+    }
+    struct send_task proto={0};
+    send_task_apply_options(&proto, options);
+    proto.response_handler = response_handler;
+    proto.timeout = timeout;
+    //与同步版本相同，直接引用段数组，由调用者保证有效直到响应回调
+    proto.iov = iov;
+    proto.iov_count = count;
+    struct send_task *task = send_task_create(context, &proto, NULL, total, NULL, 0);
+    if(task == NULL){
+        return ATC_ERROR;
+    }
+    return send_task_submit(context, task);
+}
+
+enum atc_result atc_sendv_sync(struct atc_context *context, const struct atc_iovec *iov, size_t count, const struct atc_send_options *options,
+                                    enum atc_result *send_result, char *response_buf, size_t *response_length, uint32_t timeout){
+    size_t total = (context && iov) ? send_iov_length(iov, count) : 0;
+    if(total == 0 || (response_buf != NULL && response_length == NULL)){
+        LOG_ERR("Invalid parameters");
+        return ATC_ERROR;
+    }
+    struct send_task task={0};
+    send_task_apply_options(&task, options);
+    task.timeout = timeout;
     task.sync_send_result = send_result;
     task.sync_response_buf = response_buf;
     task.sync_response_length = response_length;
-    //发送到“发送消息队列”
-    enum atc_result ret=g_atc_interface.atc_queue_send(context->send_queue, &task, 1000);
-    if(ret!=ATC_SUCCESS){
-        //发送失败，释放资源
-        g_atc_interface.atc_free(task.data);
-        g_atc_interface.atc_semaphore_delete(task.semaphore);
-        LOG_ERR("Failed to send message to send queue");
+    //调用者阻塞到命令结束，直接引用段数组
+    task.iov = iov;
+    task.iov_count = count;
+    return send_task_enqueue_wait(context, &task, NULL, total, NULL, 0);
+}
+
+enum atc_result atc_send_fmt_async(struct atc_context *context, atc_cmd_response_handler_t response_handler, uint32_t timeout, const char *fmt, ...){
+    if(context == NULL || fmt == NULL){
         return ATC_ERROR;
     }
-    //唤醒阻塞等待的处理线程
-    g_atc_interface.atc_semaphore_give(context->wake_semaphore);
-    //等待发送完成或超时
-    g_atc_interface.atc_semaphore_take(task.semaphore, ATC_TIMEOUT_MAX);
-    //释放资源
-    g_atc_interface.atc_semaphore_delete(task.semaphore);
-    return ATC_SUCCESS;
-}
-enum atc_result atc_send_async(struct atc_context *context, const char *data, size_t length, atc_cmd_response_handler_t response_handler,uint32_t timeout){
-    if(context == NULL || data == NULL || length == 0){
+    struct send_task proto={0};
+    proto.response_handler = response_handler;
+    proto.timeout = timeout;
+    va_list args;
+    va_start(args, fmt);
+    struct send_task *task = send_task_create_fmt(context, &proto, fmt, args);
+    va_end(args);
+    if(task == NULL){
         return ATC_ERROR;
     }
-    //0表示不使用超时
-    if(timeout == 0){
-        timeout = ATC_TIMEOUT_MAX;
+    return send_task_submit(context, task);
+}
+
+enum atc_result atc_send_fmt_sync(struct atc_context *context, enum atc_result *send_result, char *response_buf, size_t *response_length,
+                                    uint32_t timeout, const char *fmt, ...){
+    if(context == NULL || fmt == NULL || (response_buf != NULL && response_length == NULL)){
+        LOG_ERR("Invalid parameters");
+        return ATC_ERROR;
     }
-    //分配内存
-    struct send_task task={0};
-    task.data = g_atc_interface.atc_malloc(length);
-    if(task.data == NULL){
-        LOG_ERR("Failed to allocate memory for send_task data");
+    struct send_task proto={0};
+    proto.timeout = timeout;
+    proto.sync_send_result = send_result;
+    proto.sync_response_buf = response_buf;
+    proto.sync_response_length = response_length;
+    if(send_task_wait_prepare(context, &proto) != ATC_SUCCESS){
         return ATC_ERROR;
     }
-    memcpy(task.data, data, length);
-    task.length = length;
-    task.response_handler = response_handler;
-    task.timeout = timeout;
-    task.timestamp = 0; //初始化时间戳
-    //发送到“发送消息队列”
-    enum atc_result ret=g_atc_interface.atc_queue_send(context->send_queue, &task, 1000);
-    if(ret!=ATC_SUCCESS){
-        g_atc_interface.atc_free(task.data);
-        LOG_ERR("Failed to send message to send queue");
+    va_list args;
+    va_start(args, fmt);
+    struct send_task *task = send_task_create_fmt(context, &proto, fmt, args);
+    va_end(args);
+    if(task == NULL){
+        wait_semaphore_release(context, proto.semaphore);
         return ATC_ERROR;
     }
-    //唤醒阻塞等待的处理线程
-    g_atc_interface.atc_semaphore_give(context->wake_semaphore);
-    return ATC_SUCCESS;
+    return send_task_submit_wait(context, task);
+}
+
+enum atc_result atc_send_sync(struct atc_context *context, const char *data, size_t length,
+                                enum atc_result *send_result, char *response_buf, size_t *response_length, uint32_t timeout){
+    return atc_send_ex_sync(context, data, length, NULL, send_result, response_buf, response_length, timeout);
+}
+enum atc_result atc_send_async(struct atc_context *context, const char *data, size_t length, atc_cmd_response_handler_t response_handler,uint32_t timeout){
+    return atc_send_ex_async(context, data, length, NULL, response_handler, timeout);
 }
 
 enum atc_result atc_send_with_prompt_binary_rx_async(struct atc_context *context, const char *data, size_t data_len, 
@@ -124,159 +428,769 @@ enum atc_result atc_send_with_prompt_binary_rx_async(struct atc_context *context
     if(context == NULL || data == NULL || data_len == 0 || prompt == NULL || prompt_len == 0){
         return ATC_ERROR;
     }
-    if(timeout == 0){
-        timeout = ATC_TIMEOUT_MAX;
-    }
-    //分配内存
-    struct send_task task={0};
-    task.data = g_atc_interface.atc_malloc(data_len);
-    if(task.data == NULL){
-        LOG_ERR("Failed to allocate memory for send_task data");
+    //异步且无分块回调时二进制数据暂存在context->response中，长度受限
+    if(recv_len > ATC_RX_RESPONSE_MAX){
+        LOG_ERR("recv_len %zu exceeds ATC_RX_RESPONSE_MAX, use atc_send_with_prompt_binary_rx_stream_async", recv_len);
         return ATC_ERROR;
     }
-    memcpy(task.data, data, data_len);
-    task.length = data_len;
+    struct send_task task={0};
     task.response_handler = response_handler;
     task.timeout = timeout;
-    task.timestamp = 0; //初始化时间戳
+    task.need_recv_len = recv_len;
+    return send_task_enqueue(context, &task, data, data_len, prompt, prompt_len);
+}
 
-    //二进制接收相关
-    task.prompt = g_atc_interface.atc_malloc(prompt_len);
-    if(task.prompt == NULL){
-        g_atc_interface.atc_free(task.data);
-        LOG_ERR("Failed to allocate memory for send_task prompt");
+enum atc_result atc_send_with_prompt_binary_rx_stream_async(struct atc_context *context, const char *data, size_t data_len,
+                                                        const char* prompt, size_t prompt_len, size_t recv_len,
+                                                        atc_binary_chunk_handler_t chunk_handler, atc_cmd_response_handler_t response_handler, uint32_t timeout){
+    if(context == NULL || data == NULL || data_len == 0 || prompt == NULL || prompt_len == 0 || chunk_handler == NULL){
         return ATC_ERROR;
     }
-    memcpy(task.prompt, prompt, prompt_len);
-    task.prompt_len = prompt_len;
+    struct send_task task={0};
+    task.response_handler = response_handler;
+    task.timeout = timeout;
     task.need_recv_len = recv_len;
-    task.status = SEND_TASK_STATUS_PROMPT; //设置任务状态为提示符匹配中
+    task.chunk_handler = chunk_handler;
+    return send_task_enqueue(context, &task, data, data_len, prompt, prompt_len);
+}
 
-    //发送到“发送消息队列”
-    enum atc_result ret=g_atc_interface.atc_queue_send(context->send_queue, &task, 1000);
-    if(ret!=ATC_SUCCESS){
-        g_atc_interface.atc_free(task.data);
-        g_atc_interface.atc_free(task.prompt);
-        LOG_ERR("Failed to send message to send queue");
+//检查并设置上传载荷
+static enum atc_result send_task_apply_payload(struct send_task *task, const struct atc_tx_payload *payload){
+    if(payload == NULL || payload->length == 0 || (payload->data == NULL && payload->pull == NULL)){
         return ATC_ERROR;
     }
-    //唤醒阻塞等待的处理线程
-    g_atc_interface.atc_semaphore_give(context->wake_semaphore);
+    task->tx_data = payload->data;
+    task->tx_length = payload->length;
+    task->tx_pull = payload->pull;
+    task->tx_arg = payload->arg;
     return ATC_SUCCESS;
 }
-enum atc_result atc_send_with_prompt_binary_rx_sync(struct atc_context *context, const char *data, size_t data_len, const char* prompt, size_t prompt_len, size_t recv_len ,
-                                enum atc_result *send_result, char *response_buf, size_t *response_length, uint32_t timeout){
+
+enum atc_result atc_send_with_prompt_payload_tx_async(struct atc_context *context, const char *data, size_t data_len, const char *prompt, size_t prompt_len,
+                                const struct atc_tx_payload *payload, const struct atc_send_options *options,
+                                atc_cmd_response_handler_t response_handler, uint32_t timeout){
     if(context == NULL || data == NULL || data_len == 0 || prompt == NULL || prompt_len == 0){
         return ATC_ERROR;
     }
-    if(timeout == 0){
-        timeout = ATC_TIMEOUT_MAX;
-    }
-    //分配内存
     struct send_task task={0};
-    task.data = g_atc_interface.atc_malloc(data_len);
-    if(task.data == NULL){
-        LOG_ERR("Failed to allocate memory for send_task data");
+    send_task_apply_options(&task, options);
+    if(send_task_apply_payload(&task, payload) != ATC_SUCCESS){
+        LOG_ERR("Invalid tx payload");
         return ATC_ERROR;
     }
-    memcpy(task.data, data, data_len);
-    task.length = data_len;
-    task.response_handler = sync_response_handler;
+    task.response_handler = response_handler;
     task.timeout = timeout;
-    task.timestamp = 0; //初始化时间戳
+    return send_task_enqueue(context, &task, data, data_len, prompt, prompt_len);
+}
 
-    //设置同步发送相关参数
-    task.semaphore = g_atc_interface.atc_semaphore_create_binary();
-    if(task.semaphore == NULL){
-        g_atc_interface.atc_free(task.data);
-        LOG_ERR("Failed to create semaphore for sync send");
+enum atc_result atc_send_with_prompt_payload_tx_sync(struct atc_context *context, const char *data, size_t data_len, const char *prompt, size_t prompt_len,
+                                const struct atc_tx_payload *payload, const struct atc_send_options *options,
+                                enum atc_result *send_result, char *response_buf, size_t *response_length, uint32_t timeout){
+    if(context == NULL || data == NULL || data_len == 0 || prompt == NULL || prompt_len == 0 || (response_buf != NULL && response_length == NULL)){
+        return ATC_ERROR;
+    }
+    struct send_task task={0};
+    send_task_apply_options(&task, options);
+    if(send_task_apply_payload(&task, payload) != ATC_SUCCESS){
+        LOG_ERR("Invalid tx payload");
         return ATC_ERROR;
     }
+    task.timeout = timeout;
     task.sync_send_result = send_result;
     task.sync_response_buf = response_buf;
     task.sync_response_length = response_length;
+    return send_task_enqueue_wait(context, &task, data, data_len, prompt, prompt_len);
+}
 
-    //二进制接收相关
-    task.prompt = g_atc_interface.atc_malloc(prompt_len);
-    if(task.prompt == NULL){
-        g_atc_interface.atc_free(task.data);
-        g_atc_interface.atc_semaphore_delete(task.semaphore);
-        LOG_ERR("Failed to allocate memory for send_task prompt");
+enum atc_result atc_send_with_prompt_binary_rx_sync(struct atc_context *context, const char *data, size_t data_len, const char* prompt, size_t prompt_len, size_t recv_len ,
+                                enum atc_result *send_result, char *response_buf, size_t *response_length, uint32_t timeout){
+    if(context == NULL || data == NULL || data_len == 0 || prompt == NULL || prompt_len == 0 || (response_buf != NULL && response_length == NULL)){
         return ATC_ERROR;
     }
-    memcpy(task.prompt, prompt, prompt_len);
-    task.prompt_len = prompt_len;
+    //二进制数据直接写入调用者缓冲区，不受ATC_RX_RESPONSE_MAX限制
+    struct send_task task={0};
+    task.timeout = timeout;
     task.need_recv_len = recv_len;
-    task.status = SEND_TASK_STATUS_PROMPT; //设置任务状态为提示符匹配中
-
-    //发送到“发送消息队列”
-    enum atc_result ret=g_atc_interface.atc_queue_send(context->send_queue, &task, 1000);
-    if(ret!=ATC_SUCCESS){
-        g_atc_interface.atc_free(task.data);
-        g_atc_interface.atc_free(task.prompt);
-        g_atc_interface.atc_semaphore_delete(task.semaphore);
-        LOG_ERR("Failed to send message to send queue");
+    task.sync_send_result = send_result;
+    task.sync_response_buf = response_buf;
+    task.sync_response_length = response_length;
+    return send_task_enqueue_wait(context, &task, data, data_len, prompt, prompt_len);
+}
+
+//将脚本步骤转换为发送任务，步骤结果和响应通过同步发送的输出参数写回
+static void send_script_step_fill(struct send_task *task, const struct atc_script_step *step, struct send_script *script){
+    send_task_apply_options(task, step->options);
+    task->timeout = step->timeout;
+    task->response_handler = sync_response_handler;
+    task->sync_send_result = step->result;
+    task->sync_response_buf = step->response_buf;
+    task->sync_response_length = step->response_length;
+    task->script = script;
+}
+
+//在 command_end_handle 中调用：记录步骤结果，返回下一步要执行的任务。脚本结束时释放未执行的步骤并调用完成回调
+struct send_task *send_script_step_end(struct atc_context *context, struct send_task *task, enum atc_result result){
+    struct send_script *script = task->script;
+    if(script == NULL){
+        return NULL;
+    }
+    struct send_task *next = task->next;
+    task->next = NULL;
+    script->completed++;
+    if(result != ATC_SUCCESS && script->result == ATC_SUCCESS){
+        script->result = result;
+    }
+    if(next != NULL && (result == ATC_SUCCESS || script->policy == ATC_SCRIPT_CONTINUE_ON_ERROR)){
+        return next;
+    }
+    while(next != NULL){
+        struct send_task *rest = next->next;
+        send_task_free(context, next);
+        next = rest;
+    }
+    LOG_DEBUG("Script finished, result:%d, completed:%zu", script->result, script->completed);
+    if(script->done){
+        script->done(context, script->result, script->completed, script->done_arg);
+    }
+    g_atc_interface.atc_free(script);
+    return NULL;
+}
+
+enum atc_result atc_script_async(struct atc_context *context, const struct atc_script_step *steps, size_t count,
+                                    enum atc_script_policy policy, atc_script_done_t done, void *arg){
+    if(context == NULL || steps == NULL || count == 0){
         return ATC_ERROR;
     }
-    //唤醒阻塞等待的处理线程
-    g_atc_interface.atc_semaphore_give(context->wake_semaphore);
-    //等待发送完成或超时
-    g_atc_interface.atc_semaphore_take(task.semaphore, ATC_TIMEOUT_MAX);
-    //释放资源
-    g_atc_interface.atc_semaphore_delete(task.semaphore);
+    for(size_t i = 0; i < count; i++){
+        if(steps[i].data == NULL || steps[i].length == 0 || (steps[i].response_buf != NULL && steps[i].response_length == NULL)){
+            LOG_ERR("Invalid script step at index %zu", i);
+            return ATC_ERROR;
+        }
+    }
+    struct send_script *script = g_atc_interface.atc_malloc(sizeof(struct send_script));
+    if(script == NULL){
+        LOG_ERR("Failed to allocate memory for send_script");
+        return ATC_ERROR;
+    }
+    script->policy = policy;
+    script->result = ATC_SUCCESS;
+    script->completed = 0;
+    script->done = done;
+    script->done_arg = arg;
+
+    //所有步骤预先构造并串成链，第1步经发送队列投递，后续步骤由事件循环逐个推进
+    struct send_task *chain = NULL;
+    struct send_task **tail = &chain;
+    for(size_t i = 0; i < count; i++){
+        struct send_task step = {0};
+        send_script_step_fill(&step, &steps[i], script);
+        struct send_task *task = send_task_create(context, &step, steps[i].data, steps[i].length, NULL, 0);
+        if(task == NULL){
+            goto fail;
+        }
+        *tail = task;
+        tail = &task->next;
+    }
+    //提交失败时链头已释放，先取出其余步骤
+    struct send_task *next = chain->next;
+    if(send_task_submit(context, chain) != ATC_SUCCESS){
+        chain = next;
+        goto fail;
+    }
+    return ATC_SUCCESS;
+
+fail:
+    while(chain != NULL){
+        struct send_task *rest = chain->next;
+        send_task_free(context, chain);
+        chain = rest;
+    }
+    g_atc_interface.atc_free(script);
+    return ATC_ERROR;
+}
+
+//同步脚本等待状态，位于调用者栈上
+struct script_sync_wait{
+    void *semaphore;
+    enum atc_result result;
+    size_t completed;
+};
+
+static void script_sync_done(struct atc_context *context, enum atc_result result, size_t completed, void *arg){
+    struct script_sync_wait *wait = (struct script_sync_wait *)arg;
+    (void)context;
+    wait->result = result;
+    wait->completed = completed;
+    g_atc_interface.atc_semaphore_give(wait->semaphore);
+}
+
+enum atc_result atc_script_sync(struct atc_context *context, const struct atc_script_step *steps, size_t count,
+                                    enum atc_script_policy policy, enum atc_result *script_result, size_t *completed){
+    //检查信号量函数是否实现
+    if(g_atc_interface.atc_semaphore_take == NULL || g_atc_interface.atc_semaphore_give == NULL 
+        || g_atc_interface.atc_semaphore_create_binary == NULL || g_atc_interface.atc_semaphore_delete == NULL){
+        LOG_ERR("Semaphore functions are not implemented");
+        return ATC_ERROR;
+    }
+    struct script_sync_wait wait = {0};
+    wait.semaphore = wait_semaphore_acquire(context);
+    if(wait.semaphore == NULL){
+        LOG_ERR("Failed to create semaphore for sync script");
+        return ATC_ERROR;
+    }
+    if(atc_script_async(context, steps, count, policy, script_sync_done, &wait) != ATC_SUCCESS){
+        wait_semaphore_release(context, wait.semaphore);
+        return ATC_ERROR;
+    }
+    //等待所有步骤结束或中止
+    g_atc_interface.atc_semaphore_take(wait.semaphore, ATC_TIMEOUT_MAX);
+    wait_semaphore_release(context, wait.semaphore);
+    if(script_result){
+        *script_result = wait.result;
+    }
+    if(completed){
+        *completed = wait.completed;
+    }
+    return ATC_SUCCESS;
+}
+
+enum atc_result send_msg_queue_init(struct atc_context *context, const struct atc_config *config){
+    static const uint16_t default_depth[ATC_PRIORITY_COUNT] = {
+        [ATC_PRIORITY_NORMAL] = ATC_SEND_QUEUE_DEPTH,
+        [ATC_PRIORITY_URGENT] = ATC_SEND_QUEUE_URGENT_DEPTH,
+        [ATC_PRIORITY_BACKGROUND] = ATC_SEND_QUEUE_BACKGROUND_DEPTH,
+    };
+    for(int i = 0; i < ATC_PRIORITY_COUNT; i++){
+        uint16_t depth = (config && config->send_queue_depth[i]) ? config->send_queue_depth[i] : default_depth[i];
+        context->send_queue[i] = g_atc_interface.atc_queue_create(depth, sizeof(struct send_task *));
+        //事件循环每轮取空发送消息队列，排队数由名额限制：排队中（队列内及等待发送链表中）的命令不超过 depth
+        context->send_queue_credit[i] = g_atc_interface.atc_queue_create(depth, sizeof(uint8_t));
+        if(context->send_queue[i] == NULL || context->send_queue_credit[i] == NULL){
+            LOG_ERR("Failed to create send queue, priority:%d", i);
+            return ATC_ERROR;
+        }
+        for(uint16_t n = 0; n < depth; n++){
+            uint8_t credit = 0;
+            g_atc_interface.atc_queue_send(context->send_queue_credit[i], &credit, 0);
+        }
+    }
     return ATC_SUCCESS;
 }
 
-enum atc_result send_msg_queue_init(struct atc_context *context){
-    context->send_queue = g_atc_interface.atc_queue_create(6, sizeof(struct send_task));
-    if(context->send_queue == NULL){
-        LOG_ERR("Failed to create send queue");
+enum atc_result send_task_pool_init(struct atc_context *context, const struct atc_config *config){
+    uint16_t size = (config && config->send_task_pool_size) ? config->send_task_pool_size : ATC_SEND_TASK_POOL_SIZE;
+    context->send_task_pool = g_atc_interface.atc_malloc(sizeof(struct send_task) * size);
+    if(context->send_task_pool == NULL){
+        LOG_ERR("Failed to allocate memory for send_task pool");
         return ATC_ERROR;
     }
+    context->send_task_free_queue = g_atc_interface.atc_queue_create(size, sizeof(struct send_task *));
+    if(context->send_task_free_queue == NULL){
+        LOG_ERR("Failed to create send_task free queue");
+        return ATC_ERROR;
+    }
+    for(uint16_t i = 0; i < size; i++){
+        struct send_task *slot = &context->send_task_pool[i];
+        g_atc_interface.atc_queue_send(context->send_task_free_queue, &slot, 0);
+    }
     return ATC_SUCCESS;
 }
 
+static void send_pending_push(struct atc_context *context, struct send_task *task, bool front){
+    enum atc_priority priority = task->priority;
+    if(front){
+        task->queue_prev = NULL;
+        task->queue_next = context->send_pending_head[priority];
+        if(task->queue_next){
+            task->queue_next->queue_prev = task;
+        }
+        else{
+            context->send_pending_tail[priority] = task;
+        }
+        context->send_pending_head[priority] = task;
+    }
+    else{
+        task->queue_next = NULL;
+        task->queue_prev = context->send_pending_tail[priority];
+        if(task->queue_prev){
+            task->queue_prev->queue_next = task;
+        }
+        else{
+            context->send_pending_head[priority] = task;
+        }
+        context->send_pending_tail[priority] = task;
+    }
+}
+
+static void send_pending_remove(struct atc_context *context, struct send_task *task){
+    enum atc_priority priority = task->priority;
+    if(task->queue_prev){
+        task->queue_prev->queue_next = task->queue_next;
+    }
+    else{
+        context->send_pending_head[priority] = task->queue_next;
+    }
+    if(task->queue_next){
+        task->queue_next->queue_prev = task->queue_prev;
+    }
+    else{
+        context->send_pending_tail[priority] = task->queue_prev;
+    }
+    task->queue_prev = NULL;
+    task->queue_next = NULL;
+}
+
+
+static bool send_task_is_pending(const struct atc_context *context, const struct send_task *task){
+    return task->queue_prev != NULL || context->send_pending_head[task->priority] == task;
+}
+
+//结束未发送的命令：调用响应回调并释放，等待发送链表中的任务先摘除
+static void send_task_abort(struct atc_context *context, struct send_task *task, enum atc_result result){
+    if(send_task_is_pending(context, task)){
+        send_pending_remove(context, task);
+    }
+    send_task_credit_return(context, task);
+    //响应回调通过 current_send_task 访问任务，临时切换
+    struct send_task *current = context->current_send_task;
+    context->current_send_task = task;
+    if(task->response_handler){
+        task->response_handler(context, result, NULL, 0);
+    }
+    //命令脚本：失败后继续执行时，下一步排在同优先级最前面
+    struct send_task *next = send_script_step_end(context, task, result);
+    context->current_send_task = current;
+    timer_stop(context, &task->deadline);
+    send_task_free(context, task);
+    if(next != NULL){
+        send_pending_push(context, next, true);
+    }
+}
+
+//排队超时：命令未发送即以 ATC_TIMEOUT 结束
+static void send_task_queue_expired(struct atc_context *context, void *arg){
+    struct send_task *task = (struct send_task *)arg;
+    LOG_WARN("send task expired in queue, priority:%d", task->priority);
+    send_task_abort(context, task, ATC_TIMEOUT);
+}
+
+//把发送消息队列中的命令全部取到等待发送链表，设置了排队超时的启动定时器
+static void send_queue_drain(struct atc_context *context){
+    for(int i = 0; i < ATC_PRIORITY_COUNT; i++){
+        struct send_task *task;
+        while(g_atc_interface.atc_queue_recv(context->send_queue[i], &task, 0) == ATC_SUCCESS){
+            //还在发送消息队列中时已被取消
+            if(task->cancelled){
+                send_task_abort(context, task, ATC_CANCELLED);
+                continue;
+            }
+            send_pending_push(context, task, false);
+            if(task->queue_timeout != 0){
+                timer_start(context, &task->deadline, task->enqueue_time + task->queue_timeout, 0, send_task_queue_expired, task);
+            }
+        }
+    }
+}
+
+//按优先级从高到低取出一个等待发送的任务
+static struct send_task *send_pending_pop(struct atc_context *context){
+    static const enum atc_priority order[ATC_PRIORITY_COUNT] = {
+        ATC_PRIORITY_URGENT, ATC_PRIORITY_NORMAL, ATC_PRIORITY_BACKGROUND,
+    };
+    for(int i = 0; i < ATC_PRIORITY_COUNT; i++){
+        struct send_task *task = context->send_pending_head[order[i]];
+        if(task != NULL){
+            send_pending_remove(context, task);
+            send_task_credit_return(context, task);
+            timer_stop(context, &task->deadline);
+            return task;
+        }
+    }
+    return NULL;
+}
+
 void send_msg_handle(struct atc_context *context){
-    struct send_task rtask = {0};
+    //当前命令执行期间也持续取出排队的命令，使排队超时生效
+    send_queue_drain(context);
     if(context->current_send_task != NULL){
         //如果有当前发送任务，不处理新的发送任务
         return;
     }
-    if(g_atc_interface.atc_queue_recv(context->send_queue, &rtask, 0) == ATC_SUCCESS){
-        //记录当前发送任务
-        context->current_send_task = g_atc_interface.atc_malloc(sizeof(struct send_task));
-        if(context->current_send_task == NULL){
-            LOG_ERR("Failed to allocate memory for current_send_task");
-            //TODO 释放rtask内存
+    struct send_task *task = send_pending_pop(context);
+    if(task != NULL){
+        //记录当前发送任务，队列中传递的是任务指针，无需复制
+        context->current_send_task = task;
+        send_task_start(context);
+        //发送失败时命令立即结束，取出的空位留给下一轮
+    }
+}
+
+//命令执行阶段超时
+static void send_task_deadline_expired(struct atc_context *context, void *arg){
+    struct send_task *task = (struct send_task *)arg;
+    LOG_WARN("send task timeout:%.*s", (int)(task->iov ? task->iov[0].length : task->length), task->iov ? task->iov[0].data : task->data);
+    command_end_handle(context, ATC_TIMEOUT);
+}
+
+//按当前阶段启动当前命令的超时：等待提示符阶段使用 prompt_timeout（如设置），否则为 timeout，均从 timestamp 开始计算
+void send_task_deadline_arm(struct atc_context *context, struct send_task *task){
+    uint32_t timeout = task->timeout;
+    if(task->status == SEND_TASK_STATUS_PROMPT && task->prompt_timeout != 0){
+        timeout = task->prompt_timeout;
+    }
+    //超过时间轮可表示范围的超时视为永久等待
+    if(timeout > INT32_MAX){
+        timer_stop(context, &task->deadline);
+        return;
+    }
+    timer_start(context, &task->deadline, task->timestamp + timeout, 0, send_task_deadline_expired, task);
+}
+
+//取命令的第 index 段，普通命令只有一段
+static bool send_task_segment(const struct send_task *task, size_t index, const char **data, size_t *length){
+    if(task->iov != NULL){
+        if(index >= task->iov_count){
+            return false;
+        }
+        *data = task->iov[index].data;
+        *length = task->iov[index].length;
+        return true;
+    }
+    if(index > 0){
+        return false;
+    }
+    *data = task->data;
+    *length = task->length;
+    return true;
+}
+
+//中止正在进行的异步发送，之后当前命令可以立即结束
+static void send_tx_abort(struct atc_context *context){
+    if(g_atc_interface.atc_send_abort != NULL){
+        g_atc_interface.atc_send_abort(context);
+    }
+    context->tx_task = NULL;
+    if(context->current_send_task != NULL){
+        context->current_send_task->end_pending = false;
+    }
+}
+
+//异步发送超时未完成：中止发送，以超时结束当前命令
+static void send_tx_expired(struct atc_context *context, void *arg){
+    (void)arg;
+    LOG_ERR("Async send not completed in %u ms, abort", (unsigned int)ATC_TX_TIMEOUT_MS);
+    send_tx_abort(context);
+    command_end_handle(context, ATC_TIMEOUT);
+}
+
+//启动发送完成看门狗，占用命令的 deadline：命令已结束（等待发送完成）或命令没有超时时使用
+void send_tx_watchdog_arm(struct atc_context *context, struct send_task *task){
+    timer_start(context, &task->deadline, _atc_time_get() + ATC_TX_TIMEOUT_MS, 0, send_tx_expired, task);
+}
+
+//发送一段数据。实现了 atc_send_start 时只启动发送，完成通知到达前不能发送下一段
+static enum atc_result send_tx_write(struct atc_context *context, struct send_task *task, const char *data, size_t length){
+    if(g_atc_interface.atc_send_start == NULL){
+        return g_atc_interface.atc_send(context, data, length);
+    }
+    //完成通知可能在 atc_send_start 返回前到达，先记录。以当前完成计数为基准，被中止的发送迟到的通知不会累积
+    context->tx_task = task;
+    context->tx_start_count = ring_buffer_counter_load(&context->tx_complete_count) + 1;
+    enum atc_result ret = g_atc_interface.atc_send_start(context, data, length);
+    if(ret != ATC_SUCCESS){
+        context->tx_task = NULL;
+        return ret;
+    }
+    //命令超时会推迟到发送完成后再结束并启动看门狗；没有命令超时时由看门狗直接限制发送时间
+    if(!timer_active(&task->deadline)){
+        send_tx_watchdog_arm(context, task);
+    }
+    return ret;
+}
+
+//发送当前命令尚未发送的段，异步发送时每段完成后由 send_tx_complete_handle 继续
+static void send_task_transmit(struct atc_context *context){
+    struct send_task *task = context->current_send_task;
+    const char *data;
+    size_t length;
+    while(context->tx_task == NULL && send_task_segment(task, task->send_index, &data, &length)){
+        task->send_index++;
+        if(length == 0){
+            continue;
+        }
+        if(send_tx_write(context, task, data, length) != ATC_SUCCESS){
+            //处理硬件发送失败，调用响应处理回调通知发送失败
+            LOG_ERR("Failed to send AT command");
+            command_end_handle(context, ATC_HARDWARE_ERROR);
             return;
         }
-        *(context->current_send_task) = rtask;
-        //清空响应缓冲区
-        clear_response_buffer(context);
-        //记录发送时间
-        context->current_send_task->timestamp = _atc_time_get();
-        //打印发送的数据
+    }
+}
+
+//发送当前任务，命令脚本的后续步骤也从这里直接发送
+void send_task_start(struct atc_context *context){
+    struct send_task *task = context->current_send_task;
+    //清空响应缓冲区
+    clear_response_buffer(context);
+    //记录发送时间并启动超时
+    task->timestamp = _atc_time_get();
+    send_task_deadline_arm(context, task);
+    //打印发送的数据
 #if LOG_LEVEL >= LOG_LEVEL_DEBUG
-        g_atc_interface.atc_log(DBG_NAME"[SEND]:");
-        for(size_t i = 0; i < rtask.length; i++){
-            if(isprint((int)rtask.data[i])){
-                g_atc_interface.atc_log("%c", rtask.data[i]);
+    g_atc_interface.atc_log(DBG_NAME"[SEND]:");
+    const char *data;
+    size_t length;
+    for(size_t n = 0; send_task_segment(task, n, &data, &length); n++){
+        for(size_t i = 0; i < length; i++){
+            if(isprint((int)data[i])){
+                g_atc_interface.atc_log("%c", data[i]);
             }
             else{
-                g_atc_interface.atc_log("[0x%02X]", (unsigned char)rtask.data[i]);
+                g_atc_interface.atc_log("[0x%02X]", (unsigned char)data[i]);
             }
         }
-        g_atc_interface.atc_log("\r\n");
+    }
+    g_atc_interface.atc_log("\r\n");
 #endif
-        //发送数据
-        enum atc_result send_ret = g_atc_interface.atc_send(context, context->current_send_task->data, context->current_send_task->length);
-        if(send_ret != ATC_SUCCESS){
-            //处理硬件发送失败
+    task->send_index = 0;
+    //分段命令在没有异步发送接口时优先使用 atc_sendv 一次发送
+    if(task->iov != NULL && g_atc_interface.atc_sendv != NULL && g_atc_interface.atc_send_start == NULL){
+        task->send_index = task->iov_count;
+        if(g_atc_interface.atc_sendv(context, task->iov, task->iov_count) != ATC_SUCCESS){
             LOG_ERR("Failed to send AT command");
-            //调用响应处理回调，通知发送失败
             command_end_handle(context, ATC_HARDWARE_ERROR);
-            return;
         }
-        
+        return;
+    }
+    send_task_transmit(context);
+}
+
+//异步发送完成，在中断中调用
+void atc_tx_complete_isr(struct atc_context *context){
+    if(context == NULL){
+        return;
+    }
+    //中断是唯一的写者，读-改-写不需要原子操作；release 保证发送完成后才对事件循环可见
+    ring_buffer_counter_increment(&context->tx_complete_count);
+    g_atc_interface.atc_semaphore_give_isr(context->wake_semaphore);
+}
+
+//在事件循环中调用：异步发送完成后继续发送下一段，或结束发送期间已结束的命令
+void send_tx_complete_handle(struct atc_context *context){
+    struct send_task *task = context->tx_task;
+    if(task == NULL || ring_buffer_counter_load(&context->tx_complete_count) != context->tx_start_count){
+        return;
+    }
+    context->tx_task = NULL;
+    if(task->end_pending){
+        command_end_handle(context, task->end_result);
+    }
+    else if(task == context->current_send_task){
+        //看门狗替代的命令超时恢复为当前阶段的超时
+        send_task_deadline_arm(context, task);
+        send_task_transmit(context);
+    }
+}
+
+//上传载荷发送：每轮事件循环发送一块，返回true表示还有数据待发送
+bool send_payload_handle(struct atc_context *context){
+    struct send_task *task = context->current_send_task;
+    //异步发送时等待上一块的完成通知
+    if(task == NULL || task->status != SEND_TASK_STATUS_PAYLOAD_TX || context->tx_task != NULL){
+        return false;
+    }
+    size_t chunk = task->tx_length - task->tx_offset;
+    if(chunk > ATC_TX_CHUNK_SIZE){
+        chunk = ATC_TX_CHUNK_SIZE;
+    }
+    const char *data;
+    if(task->tx_data){
+        //直接从调用者缓冲区发送
+        data = task->tx_data + task->tx_offset;
+    }
+    else{
+        size_t pulled = task->tx_pull(context, context->tx_chunk, chunk, task->tx_offset, task->tx_arg);
+        if(pulled == 0){
+            LOG_ERR("Failed to pull tx payload at offset %zu", task->tx_offset);
+            command_end_handle(context, ATC_ERROR);
+            return false;
+        }
+        chunk = (pulled < chunk) ? pulled : chunk;
+        data = context->tx_chunk;
+    }
+    if(send_tx_write(context, task, data, chunk) != ATC_SUCCESS){
+        LOG_ERR("Failed to send tx payload");
+        command_end_handle(context, ATC_HARDWARE_ERROR);
+        return false;
+    }
+    task->tx_offset += chunk;
+    if(task->tx_offset < task->tx_length){
+        //同步发送时下一轮立即继续
+        return context->tx_task == NULL;
+    }
+    //载荷发送完毕，继续按行接收直到最终结果码
+    LOG_DEBUG("Tx payload sent, %zu bytes", task->tx_length);
+    task->status = SEND_TASK_STATUS_LINE_RECV;
+    return false;
+}
+
+//保存响应到句柄，超过容量时与同步接口一样截断，长度为实际保存的字节数
+static void cmd_response_save(struct atc_cmd *cmd, const char *response, size_t response_length){
+    if(cmd->response_size == 0){
+        return;
+    }
+    if(response == NULL){
+        response_length = 0;
+    }
+    if(response_length > cmd->response_size - 1){
+        LOG_WARN("atc_cmd response truncated from %zu to %zu bytes", response_length, cmd->response_size - 1);
+        response_length = cmd->response_size - 1;
+    }
+    if(response_length > 0 && response != cmd->response){
+        memcpy(cmd->response, response, response_length);
+    }
+    cmd->response_length = response_length;
+    cmd->response[response_length] = '\0';
+}
+
+//命令句柄的响应回调：保存结果和响应后通知调用者，调用者已释放句柄时直接回收
+static void cmd_response_handler(struct atc_context *context, enum atc_result result, const char *response, size_t response_length){
+    struct send_task *task = context->current_send_task;
+    struct atc_cmd *cmd = task->cmd;
+    task->cmd = NULL;
+    cmd->task = NULL;
+    cmd->result = result;
+    cmd_response_save(cmd, response, response_length);
+    if(cmd->detached){
+        //调用者不再等待，信号量无人获取
+        cmd_free(context, cmd, false);
+    }
+    else{
+        //此后事件循环不再访问句柄
+        g_atc_interface.atc_semaphore_give(cmd->semaphore);
+    }
+}
+
+//回收句柄。completed_taken 为false时完成通知已给出但未被获取，先取走再归还信号量
+void cmd_free(struct atc_context *context, struct atc_cmd *cmd, bool completed_taken){
+    if(!completed_taken && !cmd->detached){
+        g_atc_interface.atc_semaphore_take(cmd->semaphore, 0);
+    }
+    wait_semaphore_release(context, cmd->semaphore);
+    g_atc_interface.atc_free(cmd);
+}
+
+enum atc_result atc_send_cmd(struct atc_context *context, const char *data, size_t length, const struct atc_send_options *options,
+                                size_t response_size, uint32_t timeout, struct atc_cmd **out){
+    if(context == NULL || data == NULL || length == 0 || out == NULL){
+        LOG_ERR("Invalid parameters");
+        return ATC_ERROR;
+    }
+    *out = NULL;
+    //响应保存在句柄末尾，多留一个字节作结束符
+    size_t size = sizeof(struct atc_cmd) + (response_size ? response_size + 1 : 0);
+    struct atc_cmd *cmd = g_atc_interface.atc_malloc(size);
+    if(cmd == NULL){
+        LOG_ERR("Failed to allocate memory for atc_cmd");
+        return ATC_ERROR;
+    }
+    memset(cmd, 0, sizeof(struct atc_cmd));
+    cmd->context = context;
+    cmd->response_size = response_size ? response_size + 1 : 0;
+    cmd->semaphore = wait_semaphore_acquire(context);
+    if(cmd->semaphore == NULL){
+        LOG_ERR("Failed to create semaphore for atc_cmd");
+        g_atc_interface.atc_free(cmd);
+        return ATC_ERROR;
+    }
+    //结果缓存命中时返回已完成的句柄，响应已复制到句柄中，超过容量时同样截断
+    size_t cached_length;
+    if(options != NULL && options->cache_ttl != 0
+        && result_cache_lookup(context, data, length, cmd->response, response_size, &cached_length)){
+        cmd->result = ATC_SUCCESS;
+        cmd_response_save(cmd, cmd->response, cached_length);
+        g_atc_interface.atc_semaphore_give(cmd->semaphore);
+        *out = cmd;
+        return ATC_SUCCESS;
+    }
+    struct send_task proto={0};
+    send_task_apply_options(&proto, options);
+    proto.response_handler = cmd_response_handler;
+    proto.timeout = timeout;
+    proto.cmd = cmd;
+    struct send_task *task = send_task_create(context, &proto, data, length, NULL, 0);
+    if(task == NULL){
+        cmd_free(context, cmd, true);
+        return ATC_ERROR;
+    }
+    cmd->task = task;
+    if(send_task_submit(context, task) != ATC_SUCCESS){
+        cmd_free(context, cmd, true);
+        return ATC_ERROR;
+    }
+    *out = cmd;
+    return ATC_SUCCESS;
+}
+
+bool atc_cmd_poll(struct atc_cmd *cmd, enum atc_result *result){
+    return atc_cmd_wait(cmd, 0, result) == ATC_SUCCESS;
+}
+
+enum atc_result atc_cmd_wait(struct atc_cmd *cmd, uint32_t timeout, enum atc_result *result){
+    if(cmd == NULL){
+        return ATC_ERROR;
+    }
+    if(!cmd->finished){
+        if(g_atc_interface.atc_semaphore_take(cmd->semaphore, timeout) != ATC_SUCCESS){
+            return ATC_TIMEOUT;
+        }
+        cmd->finished = true;
+    }
+    if(result){
+        *result = cmd->result;
     }
-}
\ No newline at end of file
+    return ATC_SUCCESS;
+}
+
+const char *atc_cmd_response(const struct atc_cmd *cmd, size_t *length){
+    if(cmd == NULL || !cmd->finished || cmd->response_size == 0){
+        if(length) *length = 0;
+        return NULL;
+    }
+    if(length) *length = cmd->response_length;
+    return cmd->response;
+}
+
+//在事件循环中处理取消请求
+void cmd_cancel_handle(struct atc_context *context, struct atc_cmd *cmd){
+    struct send_task *task = cmd->task;
+    if(task == NULL){
+        //已经结束
+        return;
+    }
+    LOG_DEBUG("Cancel command %p", (void *)cmd);
+    if(task == context->current_send_task){
+        //已发出：不再等待响应。数据仍在异步发送且移植层能中止时立即中止，否则发送完成或超时后结束
+        if(task == context->tx_task && g_atc_interface.atc_send_abort != NULL){
+            send_tx_abort(context);
+        }
+        command_end_handle(context, ATC_CANCELLED);
+    }
+    else if(send_task_is_pending(context, task)){
+        send_task_abort(context, task, ATC_CANCELLED);
+    }
+    else{
+        //还在发送消息队列中，取出时结束
+        task->cancelled = true;
+    }
+}
+
+//在事件循环中处理句柄释放：命令已结束时立即回收，否则结束时回收
+void cmd_release_handle(struct atc_context *context, struct atc_cmd *cmd){
+    if(cmd->task == NULL){
+        cmd_free(context, cmd, cmd->finished);
+    }
+    else{
+        cmd->detached = true;
+    }
+}
@@ -2,19 +2,60 @@
 #define SEND_MSG_HANDLE_H
 
 #include "include/ATCortex.h"
+#include "prompt_matcher.h"
+#include "timer_wheel.h"
+
+struct send_script;
 //当前任务状态
 enum send_task_status{
     SEND_TASK_STATUS_LINE_RECV = 0,   //行接收中
     SEND_TASK_STATUS_PROMPT,    //提示符匹配中
     SEND_TASK_STATUS_BINARY, //接收二进制数据中
+    SEND_TASK_STATUS_PAYLOAD_TX, //提示符已匹配，分块发送上传载荷中，同时按行接收
+};
+
+//命令句柄
+struct atc_cmd{
+    struct atc_context *context;
+    void *semaphore;            //完成通知，来自等待信号量池
+    size_t response_size;       //response 的容量（含结束符），0表示不保存响应
+    //事件循环在给出完成通知前写入
+    enum atc_result result;
+    size_t response_length;
+    //仅事件循环访问
+    struct send_task *task;     //命令结束后为NULL
+    bool detached;              //调用者已释放句柄，结束时由事件循环回收
+    //仅调用者访问
+    bool finished;              //已获取完成通知
+    bool cancel_posted;         //投递过取消消息，释放时需经过外部API队列
+    char response[];
 };
 
 struct send_task{
-    char *data;
+    char *data;             //指向 inline_data 或 atc_malloc 分配的内存，分段命令为 NULL
     size_t length;
+    //同步分段命令直接引用调用者的段数组（调用者阻塞到命令结束），NULL表示使用 data
+    const struct atc_iovec *iov;
+    size_t iov_count;
     atc_cmd_response_handler_t response_handler;
     uint32_t timeout;
-    uint32_t timestamp;
+    uint32_t timestamp;     //发送时刻，设置了 prompt_timeout 时为匹配提示符的时刻
+    //排队与分阶段超时
+    uint32_t enqueue_time;
+    uint32_t queue_timeout;
+    uint32_t prompt_timeout;
+    uint32_t cache_ttl;     //成功时按命令数据缓存响应的有效期，0表示不缓存
+    struct timer_node deadline; //排队、等待提示符、等待响应阶段共用
+    struct send_task *queue_prev;   //事件循环等待发送链表
+    struct send_task *queue_next;
+    bool queue_credit;      //持有排队名额，离开等待发送链表时归还
+    //异步发送相关
+    size_t send_index;      //下一个要发送的段
+    bool end_pending;       //命令在数据发送完成前结束，发送完成后以 end_result 结束
+    enum atc_result end_result;
+    //命令句柄，NULL表示没有句柄
+    struct atc_cmd *cmd;
+    bool cancelled;         //还在发送消息队列中时被取消，取出时直接结束
     
     //同步发送相关
     void *semaphore;
@@ -22,15 +63,48 @@ struct send_task{
     char *sync_response_buf;
     size_t *sync_response_length;
 
+    //本条命令额外的最终结果码（调用者持有）
+    const struct atc_result_code *result_codes;
+    size_t result_code_count;
+
     //二进制数据接收相关
-    char *prompt;
-    size_t prompt_len;
+    prompt_matcher_t prompt;    //提示符匹配器，pattern为NULL表示无提示符
     size_t need_recv_len;   //需要接收的二进制数据长度
+    size_t recv_count;      //已接收的二进制数据长度
+    atc_binary_chunk_handler_t chunk_handler;   //二进制数据分块回调，NULL时写入同步缓冲区或context->response
+
+    //上传载荷相关：收到提示符后分块发送
+    const char *tx_data;    //载荷缓冲区（调用者持有），NULL时使用 tx_pull
+    size_t tx_length;       //载荷总长度，0表示没有上传载荷
+    size_t tx_offset;       //已发送的字节数
+    atc_tx_pull_t tx_pull;
+    void *tx_arg;
 
     enum send_task_status status;
+    enum atc_priority priority;
+
+    //命令脚本相关：同一脚本的后续步骤串成链，由 command_end_handle 直接推进
+    struct send_script *script;
+    struct send_task *next;
+
+    //任务池相关：短命令和提示符直接存放在槽内，不分配内存
+    bool pooled;            //槽来自context的任务池，否则由 atc_malloc 分配
+    char inline_data[ATC_SEND_TASK_INLINE_SIZE];
+    size_t inline_prompt[PROMPT_MATCHER_BUFFER_WORDS(ATC_SEND_TASK_INLINE_PROMPT_SIZE)];
 };
 
 void send_msg_handle(struct atc_context *context);
-enum atc_result send_msg_queue_init(struct atc_context *context);
+void send_task_start(struct atc_context *context);
+bool send_payload_handle(struct atc_context *context);
+void send_task_deadline_arm(struct atc_context *context, struct send_task *task);
+void send_tx_watchdog_arm(struct atc_context *context, struct send_task *task);
+void send_tx_complete_handle(struct atc_context *context);
+void cmd_free(struct atc_context *context, struct atc_cmd *cmd, bool completed_taken);
+void cmd_cancel_handle(struct atc_context *context, struct atc_cmd *cmd);
+void cmd_release_handle(struct atc_context *context, struct atc_cmd *cmd);
+void send_task_free(struct atc_context *context, struct send_task *task);
+struct send_task *send_script_step_end(struct atc_context *context, struct send_task *task, enum atc_result result);
+enum atc_result send_msg_queue_init(struct atc_context *context, const struct atc_config *config);
+enum atc_result send_task_pool_init(struct atc_context *context, const struct atc_config *config);
 
 #endif // SEND_MSG_HANDLE_H
\ No newline at end of file
@@ -0,0 +1,123 @@
+/**
+ * @Description: 异步发送测试
+ *               流式传输下模组的回复可能先于发送完成通知到达：提示符、二进制数据和结果码都已进入接收缓冲区，
+ *               命令才收到完成通知。命令结束推迟到完成通知之后，期间后续数据按行处理，事件循环不能停滞。
+ *               完成通知一直不到达时，看门狗中止发送并以超时结束命令；取消发送中的命令立即中止发送
+ */
+
+#include "test_port.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static struct atc_context test_context;
+static int abort_count;
+
+struct tx_job{
+    struct atc_context *context;
+    const char *data;
+    size_t length;
+};
+
+//模拟 DMA：先把数据交给模组（模组立即回复），稍后才通知发送完成
+static void *tx_thread(void *arg){
+    struct tx_job *job = arg;
+    test_port_send(job->context, job->data, job->length);
+    //模拟 DMA 卡死，永远不通知完成
+    if(strncmp(job->data, "AT+HANG", 7) == 0){
+        free(job);
+        return NULL;
+    }
+    test_sleep_ms(50);
+    atc_tx_complete_isr(job->context);
+    free(job);
+    return NULL;
+}
+
+static enum atc_result send_start(struct atc_context *context, const char *data, size_t length){
+    struct tx_job *job = malloc(sizeof(struct tx_job));
+    job->context = context;
+    job->data = data;
+    job->length = length;
+    pthread_t thread;
+    if(pthread_create(&thread, NULL, tx_thread, job) != 0){
+        free(job);
+        return ATC_ERROR;
+    }
+    pthread_detach(thread);
+    return ATC_SUCCESS;
+}
+
+//在事件循环中调用，与完成通知不会并发
+static void send_abort(struct atc_context *context){
+    (void)context;
+    abort_count++;
+}
+
+static void modem(struct atc_context *context, const char *data, size_t length){
+    (void)length;
+    if(strncmp(data, "AT+HANGS", 8) == 0){
+        //不回复
+    }
+    else if(strncmp(data, "AT+QIRD", 7) == 0){
+        test_feed(context, "\r\nCONNECT\r\nhello\r\nOK\r\n");
+    }
+    else{
+        test_feed(context, "\r\nOK\r\n");
+    }
+}
+
+int main(void){
+    test_port_register(modem, send_start, send_abort);
+    test_start(&test_context, NULL);
+
+    char buf[16];
+    size_t length = sizeof(buf);
+    enum atc_result result = ATC_ERROR;
+    uint32_t start = test_tick();
+    TEST_CHECK(atc_send_with_prompt_binary_rx_sync(&test_context, "AT+QIRD=0,5\r\n", 13, "CONNECT\r\n", 9, 5,
+                &result, buf, &length, 1000) == ATC_SUCCESS);
+    TEST_CHECK(result == ATC_SUCCESS);
+    TEST_CHECK(length == 5 && memcmp(buf, "hello", 5) == 0);
+    TEST_CHECK(test_tick() - start < 500);
+
+    //结束前到达的结果码不属于下一条命令
+    length = sizeof(buf);
+    TEST_CHECK(atc_send_sync(&test_context, "AT\r\n", 4, &result, buf, &length, 1000) == ATC_SUCCESS);
+    TEST_CHECK(result == ATC_SUCCESS);
+
+    //结果码已到达但发送一直未完成：看门狗到期后中止发送，命令以超时结束
+    start = test_tick();
+    TEST_CHECK(atc_send_sync(&test_context, "AT+HANG\r\n", 9, &result, NULL, NULL, 5000) == ATC_SUCCESS);
+    TEST_CHECK(result == ATC_TIMEOUT);
+    TEST_CHECK(abort_count == 1);
+    TEST_CHECK(test_tick() - start >= ATC_TX_TIMEOUT_MS && test_tick() - start < ATC_TX_TIMEOUT_MS + 1000);
+
+    //没有命令超时时看门狗同样限制发送时间
+    struct atc_cmd *cmd;
+    start = test_tick();
+    TEST_CHECK(atc_send_cmd(&test_context, "AT+HANGS\r\n", 10, NULL, 0, 0, &cmd) == ATC_SUCCESS);
+    TEST_CHECK(atc_cmd_wait(cmd, 5000, &result) == ATC_SUCCESS);
+    TEST_CHECK(result == ATC_TIMEOUT);
+    TEST_CHECK(abort_count == 2);
+    atc_cmd_release(cmd);
+
+    //取消发送中的命令立即中止发送
+    TEST_CHECK(atc_send_cmd(&test_context, "AT+HANGS\r\n", 10, NULL, 0, 0, &cmd) == ATC_SUCCESS);
+    test_sleep_ms(100);
+    start = test_tick();
+    TEST_CHECK(atc_cmd_cancel(cmd) == ATC_SUCCESS);
+    TEST_CHECK(atc_cmd_wait(cmd, 5000, &result) == ATC_SUCCESS);
+    TEST_CHECK(result == ATC_CANCELLED);
+    TEST_CHECK(abort_count == 3);
+    TEST_CHECK(test_tick() - start < 500);
+    atc_cmd_release(cmd);
+
+    //中止后发送恢复正常
+    length = sizeof(buf);
+    TEST_CHECK(atc_send_sync(&test_context, "AT\r\n", 4, &result, buf, &length, 1000) == ATC_SUCCESS);
+    TEST_CHECK(result == ATC_SUCCESS);
+    printf("async tx ok\n");
+    return 0;
+}
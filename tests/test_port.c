@@ -0,0 +1,248 @@
+/**
+ * @Description: 测试用的 pthread 接口实现和模拟模组
+ */
+
+#define _POSIX_C_SOURCE 200809L
+#include "test_port.h"
+#include <errno.h>
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+struct test_semaphore{
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    int value;
+};
+
+struct test_queue{
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    size_t depth;
+    size_t item_size;
+    size_t head;
+    size_t count;
+    char *items;
+};
+
+//模组线程待处理的发送数据
+struct test_job{
+    struct atc_context *context;
+    char *data;
+    size_t length;
+    struct test_job *next;
+};
+
+static test_modem_t test_modem;
+static pthread_mutex_t test_job_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t test_job_cond = PTHREAD_COND_INITIALIZER;
+static struct test_job *test_job_head;
+static struct test_job *test_job_tail;
+
+static void test_deadline(struct timespec *ts, uint32_t ms){
+    clock_gettime(CLOCK_REALTIME, ts);
+    ts->tv_sec += ms / 1000;
+    ts->tv_nsec += (long)(ms % 1000) * 1000000L;
+    if(ts->tv_nsec >= 1000000000L){
+        ts->tv_sec++;
+        ts->tv_nsec -= 1000000000L;
+    }
+}
+
+static void *test_semaphore_create(void){
+    struct test_semaphore *sem = calloc(1, sizeof(struct test_semaphore));
+    pthread_mutex_init(&sem->mutex, NULL);
+    pthread_cond_init(&sem->cond, NULL);
+    return sem;
+}
+
+static int test_semaphore_take(void *semaphore, uint32_t timeout){
+    struct test_semaphore *sem = semaphore;
+    struct timespec ts;
+    test_deadline(&ts, timeout);
+    pthread_mutex_lock(&sem->mutex);
+    while(!sem->value){
+        if(timeout == ATC_TIMEOUT_MAX){
+            pthread_cond_wait(&sem->cond, &sem->mutex);
+        }
+        else if(pthread_cond_timedwait(&sem->cond, &sem->mutex, &ts) == ETIMEDOUT){
+            break;
+        }
+    }
+    int ret = sem->value ? 0 : -1;
+    sem->value = 0;
+    pthread_mutex_unlock(&sem->mutex);
+    return ret;
+}
+
+static int test_semaphore_give(void *semaphore){
+    struct test_semaphore *sem = semaphore;
+    pthread_mutex_lock(&sem->mutex);
+    sem->value = 1;
+    pthread_cond_signal(&sem->cond);
+    pthread_mutex_unlock(&sem->mutex);
+    return 0;
+}
+
+static void test_semaphore_delete(void *semaphore){
+    free(semaphore);
+}
+
+static void *test_queue_create(size_t depth, size_t item_size){
+    struct test_queue *queue = calloc(1, sizeof(struct test_queue));
+    queue->depth = depth;
+    queue->item_size = item_size;
+    queue->items = malloc(depth * item_size);
+    pthread_mutex_init(&queue->mutex, NULL);
+    pthread_cond_init(&queue->cond, NULL);
+    return queue;
+}
+
+static int test_queue_send(void *handle, const void *item, uint32_t timeout){
+    struct test_queue *queue = handle;
+    struct timespec ts;
+    test_deadline(&ts, timeout);
+    pthread_mutex_lock(&queue->mutex);
+    while(queue->count == queue->depth){
+        if(timeout == 0 || pthread_cond_timedwait(&queue->cond, &queue->mutex, &ts) == ETIMEDOUT){
+            pthread_mutex_unlock(&queue->mutex);
+            return -1;
+        }
+    }
+    memcpy(queue->items + ((queue->head + queue->count) % queue->depth) * queue->item_size, item, queue->item_size);
+    queue->count++;
+    pthread_cond_broadcast(&queue->cond);
+    pthread_mutex_unlock(&queue->mutex);
+    return 0;
+}
+
+static int test_queue_recv(void *handle, void *item, uint32_t timeout){
+    struct test_queue *queue = handle;
+    struct timespec ts;
+    test_deadline(&ts, timeout);
+    pthread_mutex_lock(&queue->mutex);
+    while(queue->count == 0){
+        if(timeout == 0 || pthread_cond_timedwait(&queue->cond, &queue->mutex, &ts) == ETIMEDOUT){
+            pthread_mutex_unlock(&queue->mutex);
+            return -1;
+        }
+    }
+    memcpy(item, queue->items + queue->head * queue->item_size, queue->item_size);
+    queue->head = (queue->head + 1) % queue->depth;
+    queue->count--;
+    pthread_cond_broadcast(&queue->cond);
+    pthread_mutex_unlock(&queue->mutex);
+    return 0;
+}
+
+static int test_log(const char *fmt, ...){
+    (void)fmt;
+    return 0;
+}
+
+uint32_t test_tick(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)(ts.tv_sec * 1000 + ts.tv_nsec / 1000000);
+}
+
+void test_sleep_ms(uint32_t ms){
+    struct timespec ts = {ms / 1000, (long)(ms % 1000) * 1000000L};
+    nanosleep(&ts, NULL);
+}
+
+//模组线程：按顺序把发送的数据交给模拟模组，回复不会阻塞事件循环
+static void *test_modem_thread(void *arg){
+    (void)arg;
+    for(;;){
+        pthread_mutex_lock(&test_job_mutex);
+        while(test_job_head == NULL){
+            pthread_cond_wait(&test_job_cond, &test_job_mutex);
+        }
+        struct test_job *job = test_job_head;
+        test_job_head = job->next;
+        if(test_job_head == NULL){
+            test_job_tail = NULL;
+        }
+        pthread_mutex_unlock(&test_job_mutex);
+        if(test_modem){
+            test_modem(job->context, job->data, job->length);
+        }
+        free(job->data);
+        free(job);
+    }
+    return NULL;
+}
+
+enum atc_result test_port_send(struct atc_context *context, const char *data, size_t length){
+    struct test_job *job = calloc(1, sizeof(struct test_job));
+    job->context = context;
+    job->data = malloc(length);
+    memcpy(job->data, data, length);
+    job->length = length;
+    pthread_mutex_lock(&test_job_mutex);
+    if(test_job_tail){
+        test_job_tail->next = job;
+    }
+    else{
+        test_job_head = job;
+    }
+    test_job_tail = job;
+    pthread_cond_signal(&test_job_cond);
+    pthread_mutex_unlock(&test_job_mutex);
+    return ATC_SUCCESS;
+}
+
+void test_port_register(test_modem_t modem, atc_send_start_t send_start, atc_send_abort_t send_abort){
+    static struct atc_interface port = {
+        .atc_malloc = malloc,
+        .atc_free = free,
+        .atc_queue_create = test_queue_create,
+        .atc_queue_send = test_queue_send,
+        .atc_queue_recv = test_queue_recv,
+        .atc_log = test_log,
+        .atc_send = test_port_send,
+        .atc_semaphore_create_binary = test_semaphore_create,
+        .atc_semaphore_take = test_semaphore_take,
+        .atc_semaphore_give = test_semaphore_give,
+        .atc_semaphore_delete = test_semaphore_delete,
+        .atc_semaphore_give_isr = test_semaphore_give,
+        .atc_get_tick_ms = test_tick,
+    };
+    test_modem = modem;
+    port.atc_send_start = send_start;
+    port.atc_send_abort = send_abort;
+    atc_interface_register(&port);
+    pthread_t thread;
+    pthread_create(&thread, NULL, test_modem_thread, NULL);
+    pthread_detach(thread);
+}
+
+static void *test_loop(void *arg){
+    atc_process(arg);
+    return NULL;
+}
+
+void test_start(struct atc_context *context, const struct atc_config *config){
+    if(atc_init_ex(context, config) != ATC_SUCCESS){
+        printf("atc_init_ex failed\n");
+        exit(1);
+    }
+    pthread_t thread;
+    pthread_create(&thread, NULL, test_loop, context);
+    pthread_detach(thread);
+}
+
+void test_feed(struct atc_context *context, const char *data){
+    size_t length = strlen(data);
+    size_t offset = 0;
+    while(offset < length){
+        offset += (size_t)atc_receive_data(context, data + offset, length - offset);
+        if(offset < length){
+            test_sleep_ms(1);
+        }
+    }
+}
@@ -0,0 +1,26 @@
+#ifndef TEST_PORT_H
+#define TEST_PORT_H
+#include "ATCortex.h"
+
+//模拟模组：收到事件循环发送的数据时在模组线程中调用，可用 test_feed 回复
+typedef void (*test_modem_t)(struct atc_context *context, const char *data, size_t length);
+
+//注册基于 pthread 的接口实现，atc_send 把数据交给模组线程
+void test_port_register(test_modem_t modem, atc_send_start_t send_start, atc_send_abort_t send_abort);
+//初始化context并在新线程中运行 atc_process
+void test_start(struct atc_context *context, const struct atc_config *config);
+//把数据交给模组线程，与 atc_send 相同
+enum atc_result test_port_send(struct atc_context *context, const char *data, size_t length);
+//模拟串口接收，缓冲区满时等待
+void test_feed(struct atc_context *context, const char *data);
+uint32_t test_tick(void);
+void test_sleep_ms(uint32_t ms);
+
+#define TEST_CHECK(cond) do{ \
+        if(!(cond)){ \
+            printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+            return 1; \
+        } \
+    }while(0)
+
+#endif // TEST_PORT_H
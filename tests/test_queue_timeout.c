@@ -0,0 +1,68 @@
+/**
+ * @Description: 排队超时测试
+ *               当前命令一直没有响应、队列前部是不限排队时间的命令时，排在后面的命令仍应在排队超时后结束，
+ *               结束后让出的名额可以立即被新命令使用
+ */
+
+#include "test_port.h"
+#include <stdio.h>
+#include <string.h>
+
+#define TEST_QUEUE_DEPTH 4
+
+#define TEST_EXPIRING (TEST_QUEUE_DEPTH / 2)
+
+static struct atc_context test_context;
+static volatile int test_done;
+static enum atc_result test_results[TEST_EXPIRING];
+
+static void modem(struct atc_context *context, const char *data, size_t length){
+    (void)length;
+    //AT+STUCK 不回复
+    if(strncmp(data, "AT+STUCK", 8) != 0){
+        test_feed(context, "\r\nOK\r\n");
+    }
+}
+
+static void queued_handler(struct atc_context *context, enum atc_result result, const char *response, size_t length){
+    (void)context;
+    (void)response;
+    (void)length;
+    test_results[test_done++] = result;
+}
+
+int main(void){
+    test_port_register(modem, NULL, NULL);
+    struct atc_config config = {0};
+    config.send_queue_depth[ATC_PRIORITY_NORMAL] = TEST_QUEUE_DEPTH;
+    test_start(&test_context, &config);
+
+    TEST_CHECK(atc_send_async(&test_context, "AT+STUCK\r\n", 10, NULL, 5000) == ATC_SUCCESS);
+    test_sleep_ms(20);
+    //队列排满：前一半不限排队时间，后一半要在排队超时后结束
+    for(int i = 0; i < TEST_QUEUE_DEPTH - TEST_EXPIRING; i++){
+        TEST_CHECK(atc_send_async(&test_context, "AT+N\r\n", 6, NULL, 1000) == ATC_SUCCESS);
+    }
+    struct atc_send_options options = {.queue_timeout = 100};
+    uint32_t start = test_tick();
+    for(int i = 0; i < TEST_EXPIRING; i++){
+        TEST_CHECK(atc_send_ex_async(&test_context, "AT+Q\r\n", 6, &options, queued_handler, 1000) == ATC_SUCCESS);
+    }
+    while(test_done < TEST_EXPIRING && test_tick() - start < 1000){
+        test_sleep_ms(5);
+    }
+    TEST_CHECK(test_done == TEST_EXPIRING);
+    for(int i = 0; i < TEST_EXPIRING; i++){
+        TEST_CHECK(test_results[i] == ATC_TIMEOUT);
+    }
+    TEST_CHECK(test_tick() - start < 500);
+
+    //队列中还有不限排队时间的命令，同步调用取得让出的名额，同样按时返回
+    enum atc_result result = ATC_SUCCESS;
+    start = test_tick();
+    TEST_CHECK(atc_send_ex_sync(&test_context, "AT+Q\r\n", 6, &options, &result, NULL, NULL, 1000) == ATC_SUCCESS);
+    TEST_CHECK(result == ATC_TIMEOUT);
+    TEST_CHECK(test_tick() - start < 500);
+    printf("queue timeout ok\n");
+    return 0;
+}
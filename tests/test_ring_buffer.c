@@ -0,0 +1,163 @@
+/**
+ * @Description: 环形缓冲区双线程压力测试
+ *               生产者线程轮流使用 write / write_block / write_span+commit 写入递增序列，
+ *               消费者线程轮流使用 read / read_block / read_span+commit 读取并校验，
+ *               小容量缓冲区使读写指针频繁跨越绕回点。
+ *               另用两个单写者计数器交替发布数据，校验 ring_buffer_counter_increment/load 的 release/acquire 语义
+ */
+
+#include "ring_buffer.h"
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <string.h>
+
+#define TEST_CAPACITY 64
+#define TEST_TOTAL 2000000u
+#define TEST_HANDOFFS 100000u
+
+static unsigned char test_memory[TEST_CAPACITY];
+static ring_buffer_t test_ring;
+
+static void *producer(void *arg){
+    (void)arg;
+    unsigned int sent = 0;
+    unsigned int round = 0;
+    unsigned char block[37];
+    while(sent < TEST_TOTAL){
+        unsigned int written = 0;
+        unsigned int left = TEST_TOTAL - sent;
+        switch(round++ % 3){
+        case 0:
+            written = ring_buffer_write(&test_ring, (unsigned char)sent);
+            break;
+        case 1:{
+            unsigned int length = (left < sizeof(block)) ? left : sizeof(block);
+            for(unsigned int i = 0; i < length; i++){
+                block[i] = (unsigned char)(sent + i);
+            }
+            written = ring_buffer_write_block(&test_ring, block, length);
+            break;
+        }
+        default:{
+            unsigned char *span;
+            unsigned int length = ring_buffer_write_span(&test_ring, &span);
+            if(length > left){
+                length = left;
+            }
+            for(unsigned int i = 0; i < length; i++){
+                span[i] = (unsigned char)(sent + i);
+            }
+            written = ring_buffer_write_commit(&test_ring, length);
+            break;
+        }
+        }
+        if(written == 0){
+            sched_yield();
+        }
+        sent += written;
+    }
+    return NULL;
+}
+
+//计数器交接：生产者写入数据后发布 test_posted，消费者校验后发布 test_acked，下一轮才能覆盖数据
+static unsigned int test_slot[4];
+static ring_buffer_index_t test_posted;
+static ring_buffer_index_t test_acked;
+
+static void *counter_producer(void *arg){
+    (void)arg;
+    for(unsigned int i = 1; i <= TEST_HANDOFFS; i++){
+        while(ring_buffer_counter_load(&test_acked) != i - 1){
+            sched_yield();
+        }
+        for(unsigned int k = 0; k < 4; k++){
+            test_slot[k] = i * 4 + k;
+        }
+        ring_buffer_counter_increment(&test_posted);
+    }
+    return NULL;
+}
+
+static unsigned long counter_test(void){
+    pthread_t thread;
+    if(pthread_create(&thread, NULL, counter_producer, NULL) != 0){
+        return 1;
+    }
+    unsigned long errors = 0;
+    for(unsigned int i = 1; i <= TEST_HANDOFFS; i++){
+        while(ring_buffer_counter_load(&test_posted) != i){
+            sched_yield();
+        }
+        for(unsigned int k = 0; k < 4; k++){
+            if(test_slot[k] != i * 4 + k){
+                errors++;
+            }
+        }
+        ring_buffer_counter_increment(&test_acked);
+    }
+    pthread_join(thread, NULL);
+    return errors;
+}
+
+int main(void){
+    //容量不是 2 的幂时初始化失败
+    if(ring_buffer_init(&test_ring, test_memory, TEST_CAPACITY - 1)){
+        printf("non power-of-two capacity accepted\n");
+        return 1;
+    }
+    if(!ring_buffer_init(&test_ring, test_memory, TEST_CAPACITY)){
+        printf("init failed\n");
+        return 1;
+    }
+    pthread_t thread;
+    if(pthread_create(&thread, NULL, producer, NULL) != 0){
+        printf("pthread_create failed\n");
+        return 1;
+    }
+    unsigned int received = 0;
+    unsigned int round = 0;
+    unsigned long errors = 0;
+    unsigned char block[29];
+    while(received < TEST_TOTAL){
+        unsigned int length = 0;
+        switch(round++ % 3){
+        case 0:{
+            unsigned char byte;
+            length = ring_buffer_read(&test_ring, &byte);
+            if(length && byte != (unsigned char)received){
+                errors++;
+            }
+            break;
+        }
+        case 1:
+            length = ring_buffer_read_block(&test_ring, block, sizeof(block));
+            for(unsigned int i = 0; i < length; i++){
+                if(block[i] != (unsigned char)(received + i)){
+                    errors++;
+                }
+            }
+            break;
+        default:{
+            const unsigned char *span;
+            length = ring_buffer_read_span(&test_ring, &span);
+            for(unsigned int i = 0; i < length; i++){
+                if(span[i] != (unsigned char)(received + i)){
+                    errors++;
+                }
+            }
+            length = ring_buffer_read_commit(&test_ring, length);
+            break;
+        }
+        }
+        if(length == 0){
+            sched_yield();
+        }
+        received += length;
+    }
+    pthread_join(thread, NULL);
+    int remain = ring_buffer_data_count(&test_ring);
+    unsigned long counter_errors = counter_test();
+    printf("received=%u errors=%lu remain=%d counter_errors=%lu\n", received, errors, remain, counter_errors);
+    return (errors == 0 && remain == 0 && counter_errors == 0) ? 0 : 1;
+}
@@ -0,0 +1,51 @@
+/**
+ * @Description: 延迟URC反注册测试
+ *               处理函数正在 atc_urc_dispatch 中执行时反注册，反注册返回时处理函数已经返回，之后不会再执行
+ */
+
+#include "test_port.h"
+#include <pthread.h>
+#include <stdio.h>
+
+static struct atc_context test_context;
+static volatile int test_started;
+static volatile int test_finished;
+
+static void slow_handler(struct atc_context *context, const char *line){
+    (void)context;
+    (void)line;
+    test_started++;
+    test_sleep_ms(100);
+    test_finished++;
+}
+
+static void *dispatch_thread(void *arg){
+    for(;;){
+        atc_urc_dispatch(arg, ATC_TIMEOUT_MAX);
+    }
+    return NULL;
+}
+
+int main(void){
+    test_port_register(NULL, NULL, NULL);
+    test_start(&test_context, NULL);
+    pthread_t thread;
+    pthread_create(&thread, NULL, dispatch_thread, &test_context);
+
+    struct atc_urc_options options = {.deferred = true};
+    int id = atc_urc_register_ex(&test_context, "+SLOW:", slow_handler, &options);
+    TEST_CHECK(id > 0);
+    test_feed(&test_context, "+SLOW: 1\r\n+SLOW: 2\r\n");
+    uint32_t start = test_tick();
+    while(test_started == 0 && test_tick() - start < 1000){
+        test_sleep_ms(1);
+    }
+    TEST_CHECK(test_started == 1);
+    //第一条正在执行，第二条还在队列中
+    TEST_CHECK(atc_urc_unregister(&test_context, id) == ATC_SUCCESS);
+    TEST_CHECK(test_finished == 1);
+    test_sleep_ms(200);
+    TEST_CHECK(test_started == 1);
+    printf("urc defer unregister ok\n");
+    return 0;
+}
@@ -0,0 +1,169 @@
+/**
+ * @Description: 分层时间轮
+ *               命令的排队/提示符/响应超时和URC限流间隔都挂在时间轮上，启动、停止为O(1)，
+ *               事件循环每轮只检查各层位图即可得到最近的到期时刻，阻塞到该时刻为止
+ */
+
+#include "timer_wheel.h"
+#include "log.h"
+#include <string.h>
+
+static uint32_t timer_ctz(uint32_t value){
+#if defined(__GNUC__)
+    return (uint32_t)__builtin_ctz(value);
+#else
+    uint32_t n = 0;
+    while((value & 1u) == 0){
+        value >>= 1;
+        n++;
+    }
+    return n;
+#endif
+}
+
+//按到期时刻与时间轮当前时刻的距离选择层和槽
+static void timer_insert(struct timer_wheel *wheel, struct timer_node *timer){
+    uint32_t level = 0;
+    uint32_t slot = wheel->now & TIMER_WHEEL_MASK;
+    //已到期的定时器放在第0层当前槽，下一次推进时立即处理
+    if((int32_t)(timer->expires - wheel->now) > 0){
+        for(level = 0; level < TIMER_WHEEL_LEVELS; level++){
+            uint32_t shift = level * TIMER_WHEEL_BITS;
+            uint32_t distance = ((timer->expires >> shift) - (wheel->now >> shift)) & (0xFFFFFFFFu >> shift);
+            if(distance < TIMER_WHEEL_SLOTS){
+                slot = (timer->expires >> shift) & TIMER_WHEEL_MASK;
+                break;
+            }
+        }
+        if(level == TIMER_WHEEL_LEVELS){
+            //超出最高层范围：放在最高层最远的槽，级联时重新放置
+            level = TIMER_WHEEL_LEVELS - 1;
+            slot = ((wheel->now >> (level * TIMER_WHEEL_BITS)) + TIMER_WHEEL_MASK) & TIMER_WHEEL_MASK;
+        }
+    }
+    struct timer_node **head = &wheel->slots[level][slot];
+    timer->level = (uint8_t)level;
+    timer->slot = (uint8_t)slot;
+    timer->next = *head;
+    if(*head){
+        (*head)->pprev = &timer->next;
+    }
+    timer->pprev = head;
+    *head = timer;
+    wheel->occupied[level] |= 1u << slot;
+}
+
+static void timer_unlink(struct timer_wheel *wheel, struct timer_node *timer){
+    *timer->pprev = timer->next;
+    if(timer->next){
+        timer->next->pprev = timer->pprev;
+    }
+    if(wheel->slots[timer->level][timer->slot] == NULL){
+        wheel->occupied[timer->level] &= ~(1u << timer->slot);
+    }
+    timer->next = NULL;
+    timer->pprev = NULL;
+}
+
+//最近的事件时刻：第0层为到期时刻，更高层为需要级联的槽的起始时刻。没有定时器时返回false
+static bool timer_wheel_next(const struct timer_wheel *wheel, uint32_t *next){
+    bool found = false;
+    uint32_t nearest = 0;
+    for(uint32_t level = 0; level < TIMER_WHEEL_LEVELS; level++){
+        uint32_t occupied = wheel->occupied[level];
+        if(occupied == 0){
+            continue;
+        }
+        uint32_t shift = level * TIMER_WHEEL_BITS;
+        uint32_t current = (wheel->now >> shift) & TIMER_WHEEL_MASK;
+        //从当前槽开始向后找第一个非空槽
+        uint32_t rotated = current ? ((occupied >> current) | (occupied << (TIMER_WHEEL_SLOTS - current))) : occupied;
+        uint32_t offset = timer_ctz(rotated);
+        uint32_t time = (level == 0) ? wheel->now + offset : ((wheel->now >> shift) + offset) << shift;
+        uint32_t distance = time - wheel->now;
+        if(!found || distance < nearest){
+            nearest = distance;
+            found = true;
+        }
+    }
+    *next = wheel->now + nearest;
+    return found;
+}
+
+enum atc_result timer_wheel_init(struct atc_context *context){
+    context->timer_wheel = g_atc_interface.atc_malloc(sizeof(struct timer_wheel));
+    if(context->timer_wheel == NULL){
+        LOG_ERR("Failed to allocate memory for timer wheel");
+        return ATC_ERROR;
+    }
+    memset(context->timer_wheel, 0, sizeof(struct timer_wheel));
+    context->timer_wheel->now = _atc_time_get();
+    return ATC_SUCCESS;
+}
+
+//在事件循环中调用：启动（或重新启动）定时器，expires 为到期时刻，距现在不能超过 2^31 毫秒
+void timer_start(struct atc_context *context, struct timer_node *timer, uint32_t expires, uint32_t period,
+                    timer_handler_t handler, void *arg){
+    if(timer_active(timer)){
+        timer_unlink(context->timer_wheel, timer);
+    }
+    timer->expires = expires;
+    timer->period = period;
+    timer->handler = handler;
+    timer->arg = arg;
+    timer_insert(context->timer_wheel, timer);
+}
+
+//在事件循环中调用：停止定时器，未启动时无操作
+void timer_stop(struct atc_context *context, struct timer_node *timer){
+    if(timer_active(timer)){
+        timer_unlink(context->timer_wheel, timer);
+    }
+}
+
+//在事件循环中调用：推进时间轮并执行到期的定时器
+void timer_wheel_run(struct atc_context *context){
+    struct timer_wheel *wheel = context->timer_wheel;
+    uint32_t now = _atc_time_get();
+    uint32_t next;
+    while(timer_wheel_next(wheel, &next) && (int32_t)(next - now) <= 0){
+        wheel->now = next;
+        //到达高层槽的起始时刻，把槽内的定时器重新放置到低层
+        for(uint32_t level = TIMER_WHEEL_LEVELS - 1; level > 0; level--){
+            uint32_t shift = level * TIMER_WHEEL_BITS;
+            if((next & ((1u << shift) - 1)) != 0){
+                continue;
+            }
+            struct timer_node **head = &wheel->slots[level][(next >> shift) & TIMER_WHEEL_MASK];
+            while(*head){
+                struct timer_node *timer = *head;
+                timer_unlink(wheel, timer);
+                timer_insert(wheel, timer);
+            }
+        }
+        //第0层当前槽的定时器全部到期。逐个取出，回调中可以安全地启动/停止其他定时器
+        struct timer_node **head = &wheel->slots[0][next & TIMER_WHEEL_MASK];
+        while(*head){
+            struct timer_node *timer = *head;
+            timer_unlink(wheel, timer);
+            if(timer->period != 0){
+                timer->expires += timer->period;
+                timer_insert(wheel, timer);
+            }
+            timer->handler(context, timer->arg);
+        }
+    }
+    //到下一个事件之前没有定时器，直接推进
+    wheel->now = now;
+}
+
+//返回距下一个事件的毫秒数，已有到期事件时返回0，没有定时器时返回 ATC_TIMEOUT_MAX
+uint32_t timer_wheel_wait_ms(struct atc_context *context){
+    struct timer_wheel *wheel = context->timer_wheel;
+    uint32_t next;
+    if(!timer_wheel_next(wheel, &next)){
+        return ATC_TIMEOUT_MAX;
+    }
+    uint32_t now = _atc_time_get();
+    return ((int32_t)(next - now) > 0) ? next - now : 0;
+}
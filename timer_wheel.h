@@ -0,0 +1,43 @@
+#ifndef TIMER_WHEEL_H
+#define TIMER_WHEEL_H
+#include "include/ATCortex.h"
+
+//分层时间轮：每层32个槽，第n层每槽跨度为 32^n 毫秒，4层覆盖约17分钟，更远的定时器在级联时重新放置
+#define TIMER_WHEEL_BITS 5
+#define TIMER_WHEEL_SLOTS (1u << TIMER_WHEEL_BITS)
+#define TIMER_WHEEL_MASK (TIMER_WHEEL_SLOTS - 1)
+#define TIMER_WHEEL_LEVELS 4
+
+//定时器到期回调，在事件循环中执行，可以启动/停止任意定时器
+typedef void (*timer_handler_t)(struct atc_context *context, void *arg);
+
+//定时器节点，嵌入在使用者的结构体中，全0为未启动状态
+struct timer_node{
+    struct timer_node *next;
+    struct timer_node **pprev;  //NULL表示未启动
+    uint32_t expires;           //到期时刻（毫秒tick）
+    uint32_t period;            //周期（毫秒），0表示单次
+    uint8_t level;
+    uint8_t slot;
+    timer_handler_t handler;
+    void *arg;
+};
+
+struct timer_wheel{
+    uint32_t now;                                   //时间轮已推进到的时刻
+    uint32_t occupied[TIMER_WHEEL_LEVELS];          //各层非空槽位图
+    struct timer_node *slots[TIMER_WHEEL_LEVELS][TIMER_WHEEL_SLOTS];
+};
+
+enum atc_result timer_wheel_init(struct atc_context *context);
+void timer_start(struct atc_context *context, struct timer_node *timer, uint32_t expires, uint32_t period,
+                    timer_handler_t handler, void *arg);
+void timer_stop(struct atc_context *context, struct timer_node *timer);
+void timer_wheel_run(struct atc_context *context);
+uint32_t timer_wheel_wait_ms(struct atc_context *context);
+
+static inline bool timer_active(const struct timer_node *timer){
+    return timer->pprev != NULL;
+}
+
+#endif // TIMER_WHEEL_H
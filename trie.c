@@ -0,0 +1,176 @@
+//trie.c
+#include "interface.h"
+#include "trie.h"
+
+#define TRIE_MALLOC g_atc_interface.atc_malloc
+#define TRIE_FREE   g_atc_interface.atc_free
+
+/* 内部辅助函数：在 node 的子节点中查找字节 key */
+static trie_node_t *_trie_child(const trie_node_t *node, unsigned char key) {
+    trie_node_t *child = node->child;
+    while (child && child->key != key) {
+        child = child->sibling;
+    }
+    return child;
+}
+
+/* 内部辅助函数：沿键下行，返回键对应的节点 */
+static trie_node_t *_trie_walk(const trie_t *trie, const char *key, size_t length) {
+    const trie_node_t *node = &trie->root;
+    for (size_t i = 0; i < length && node; i++) {
+        node = _trie_child(node, (unsigned char)key[i]);
+    }
+    return (trie_node_t *)node;
+}
+
+/* 内部辅助函数：递归释放子树 */
+static void _trie_free_subtree(trie_node_t *node, trie_free_cb free_fn) {
+    while (node) {
+        trie_node_t *sibling = node->sibling;
+        _trie_free_subtree(node->child, free_fn);
+        if (free_fn && node->value) {
+            free_fn(node->value);
+        }
+        TRIE_FREE(node);
+        node = sibling;
+    }
+}
+
+trie_t *trie_create(trie_free_cb free_fn) {
+    trie_t *trie = (trie_t *)TRIE_MALLOC(sizeof(trie_t));
+    if (trie) {
+        trie->root.child = NULL;
+        trie->root.sibling = NULL;
+        trie->root.value = NULL;
+        trie->root.key = 0;
+        trie->count = 0;
+        trie->free_fn = free_fn;
+    }
+    return trie;
+}
+
+void trie_destroy(trie_t *trie) {
+    if (!trie) return;
+    _trie_free_subtree(trie->root.child, trie->free_fn);
+    TRIE_FREE(trie);
+}
+
+int trie_insert(trie_t *trie, const char *key, size_t length, void *value) {
+    if (!trie || !key || length == 0 || !value) return -1;
+
+    trie_node_t *node = &trie->root;
+    size_t i = 0;
+    // 沿已有路径下行
+    for (; i < length; i++) {
+        trie_node_t *child = _trie_child(node, (unsigned char)key[i]);
+        if (!child) break;
+        node = child;
+    }
+    if (i == length && node->value) return -1; // 键已存在
+
+    // 补齐剩余路径。先整体分配，失败时回滚，避免留下悬空节点
+    trie_node_t *chain = NULL;
+    trie_node_t *tail = NULL;
+    for (size_t j = i; j < length; j++) {
+        trie_node_t *n = (trie_node_t *)TRIE_MALLOC(sizeof(trie_node_t));
+        if (!n) {
+            _trie_free_subtree(chain, NULL);
+            return -1;
+        }
+        n->child = NULL;
+        n->sibling = NULL;
+        n->value = NULL;
+        n->key = (unsigned char)key[j];
+        if (tail) tail->child = n;
+        else chain = n;
+        tail = n;
+    }
+    if (chain) {
+        chain->sibling = node->child;
+        node->child = chain;
+        node = tail;
+    }
+
+    node->value = value;
+    trie->count++;
+    return 0;
+}
+
+void *trie_find(const trie_t *trie, const char *key, size_t length) {
+    if (!trie || !key || length == 0) return NULL;
+    trie_node_t *node = _trie_walk(trie, key, length);
+    return node ? node->value : NULL;
+}
+
+void **trie_find_slot(trie_t *trie, const char *key, size_t length) {
+    if (!trie || !key || length == 0) return NULL;
+    trie_node_t *node = _trie_walk(trie, key, length);
+    return (node && node->value) ? &node->value : NULL;
+}
+
+void *trie_remove(trie_t *trie, const char *key, size_t length) {
+    if (!trie || !key || length == 0) return NULL;
+
+    trie_node_t *node = _trie_walk(trie, key, length);
+    if (!node || !node->value) return NULL;
+    void *value = node->value;
+    node->value = NULL;
+    trie->count--;
+
+    // 从根重新下行，记录最后一个仍需保留的节点，剪掉其后无用的单链分支
+    trie_node_t *keep = &trie->root;
+    trie_node_t *cut = _trie_child(&trie->root, (unsigned char)key[0]);
+    trie_node_t *curr = cut;
+    for (size_t i = 1; i < length; i++) {
+        // 当前节点有值或有多个子节点，则它必须保留
+        if (curr->value || curr->child->sibling) {
+            keep = curr;
+            cut = _trie_child(curr, (unsigned char)key[i]);
+        }
+        curr = _trie_child(curr, (unsigned char)key[i]);
+    }
+    if (curr->child) return value; // 目标节点还有子节点，不能剪
+
+    // 将 cut 从 keep 的子链表中摘除并释放整条分支
+    trie_node_t **link = &keep->child;
+    while (*link != cut) {
+        link = &(*link)->sibling;
+    }
+    *link = cut->sibling;
+    cut->sibling = NULL;
+    _trie_free_subtree(cut, NULL);
+    return value;
+}
+
+void *trie_longest_prefix(const trie_t *trie, const char *text, size_t length, size_t *prefix_length) {
+    if (!trie || !text) return NULL;
+
+    const trie_node_t *node = &trie->root;
+    void *best = NULL;
+    size_t best_length = 0;
+    for (size_t i = 0; i < length; i++) {
+        node = _trie_child(node, (unsigned char)text[i]);
+        if (!node) break;
+        if (node->value) {
+            best = node->value;
+            best_length = i + 1;
+        }
+    }
+    if (prefix_length) *prefix_length = best_length;
+    return best;
+}
+
+void trie_foreach_prefix(const trie_t *trie, const char *text, size_t length, trie_visit_cb cb, void *arg) {
+    if (!trie || !text || !cb) return;
+
+    const trie_node_t *node = &trie->root;
+    for (size_t i = 0; i < length; i++) {
+        node = _trie_child(node, (unsigned char)text[i]);
+        if (!node) return;
+        if (node->value && !cb(node->value, i + 1, arg)) return;
+    }
+}
+
+size_t trie_count(const trie_t *trie) {
+    return trie ? trie->count : 0;
+}
@@ -0,0 +1,97 @@
+//trie.h
+#ifndef _TRIE_H_
+#define _TRIE_H_
+
+#include <stddef.h> /* for size_t */
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * 字节前缀树
+ * 用于按前缀对行进行分类：沿输入逐字节下行一次，即可找到输入的所有已注册前缀，
+ * 耗时与前缀长度成正比，与注册的键数量无关。
+ */
+
+/* 节点定义（子节点用"首子/兄弟"链表存储，节省内存） */
+typedef struct trie_node {
+    struct trie_node *child;    /* 第一个子节点 */
+    struct trie_node *sibling;  /* 下一个兄弟节点 */
+    void *value;                /* 用户数据，非 NULL 表示根到此节点构成一个完整的键 */
+    unsigned char key;          /* 本节点对应的字节 */
+} trie_node_t;
+
+/* 数据释放回调函数原型 value：用户数据 */
+typedef void (*trie_free_cb)(void *value);
+
+/* 前缀遍历回调，prefix_length 为匹配的前缀长度。返回 false 停止遍历 */
+typedef bool (*trie_visit_cb)(void *value, size_t prefix_length, void *arg);
+
+/* 前缀树定义 */
+typedef struct trie {
+    trie_node_t root;           /* 根节点（空键） */
+    size_t count;               /* 键数量 */
+    trie_free_cb free_fn;       /* 数据释放回调 (可选) */
+} trie_t;
+
+/**
+ * @brief 创建一棵新前缀树
+ * @param free_fn 可选的数据释放回调，如果不需要自动释放数据传 NULL
+ * @return 前缀树指针，失败返回 NULL
+ */
+trie_t *trie_create(trie_free_cb free_fn);
+
+/**
+ * @brief 销毁前缀树。如果设置了 free_fn，也会释放数据内存。
+ */
+void trie_destroy(trie_t *trie);
+
+/**
+ * @brief 插入键值。键已存在时失败
+ * @param value 用户数据，不能为 NULL
+ * @return 0 成功, -1 参数非法/键已存在/内存不足
+ */
+int trie_insert(trie_t *trie, const char *key, size_t length, void *value);
+
+/**
+ * @brief 精确查找键
+ * @return 用户数据，未找到返回 NULL
+ */
+void *trie_find(const trie_t *trie, const char *key, size_t length);
+
+/**
+ * @brief 获取键对应的数据槽，可直接修改槽中的数据指针
+ * @note 键不存在时返回 NULL，不会创建
+ */
+void **trie_find_slot(trie_t *trie, const char *key, size_t length);
+
+/**
+ * @brief 删除键并回收不再使用的节点。不会调用 free_fn，数据由调用者处理
+ * @return 被删除的用户数据，未找到返回 NULL
+ */
+void *trie_remove(trie_t *trie, const char *key, size_t length);
+
+/**
+ * @brief 查找 text 的最长已注册前缀
+ * @param prefix_length 输出匹配的前缀长度，可以为 NULL
+ * @return 用户数据，没有任何前缀匹配返回 NULL
+ */
+void *trie_longest_prefix(const trie_t *trie, const char *text, size_t length, size_t *prefix_length);
+
+/**
+ * @brief 按从短到长的顺序遍历 text 的所有已注册前缀
+ */
+void trie_foreach_prefix(const trie_t *trie, const char *text, size_t length, trie_visit_cb cb, void *arg);
+
+/**
+ * @brief 获取键数量
+ */
+size_t trie_count(const trie_t *trie);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // _TRIE_H_
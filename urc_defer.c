@@ -0,0 +1,228 @@
+/**
+ * @Description: 延迟URC派发模块
+ *               事件循环只把URC行复制进预分配的槽，处理函数由 atc_urc_dispatch 在其他线程执行，
+ *               慢处理函数不会阻塞接收缓冲区的消费
+ */
+
+#include "urc_defer.h"
+#include "urc_handle.h"
+#include "log.h"
+#include <string.h>
+
+static void urc_defer_lock(struct atc_context *context){
+    g_atc_interface.atc_semaphore_take(context->urc_defer_lock, ATC_TIMEOUT_MAX);
+}
+
+static void urc_defer_unlock(struct atc_context *context){
+    g_atc_interface.atc_semaphore_give(context->urc_defer_lock);
+}
+
+enum atc_result urc_defer_init(struct atc_context *context){
+    //二值信号量作互斥锁使用，创建后先释放一次
+    context->urc_defer_lock = g_atc_interface.atc_semaphore_create_binary();
+    if(context->urc_defer_lock == NULL){
+        LOG_ERR("Failed to create urc defer lock");
+        return ATC_ERROR;
+    }
+    g_atc_interface.atc_semaphore_give(context->urc_defer_lock);
+    context->urc_defer_semaphore = g_atc_interface.atc_semaphore_create_binary();
+    context->urc_defer_done_semaphore = g_atc_interface.atc_semaphore_create_binary();
+    if(context->urc_defer_semaphore == NULL || context->urc_defer_done_semaphore == NULL){
+        LOG_ERR("Failed to create urc defer semaphore");
+        return ATC_ERROR;
+    }
+    return ATC_SUCCESS;
+}
+
+//首次注册延迟处理函数时分配槽，之后不再分配
+enum atc_result urc_defer_slots_alloc(struct atc_context *context){
+    if(context->urc_defer_slots != NULL){
+        return ATC_SUCCESS;
+    }
+    size_t size = sizeof(struct urc_defer_slot) * ATC_URC_DEFER_QUEUE_DEPTH;
+    struct urc_defer_slot *slots = g_atc_interface.atc_malloc(size);
+    if(slots == NULL){
+        LOG_ERR("Failed to allocate memory for urc defer slots");
+        return ATC_ERROR;
+    }
+    memset(slots, 0, size);
+    urc_defer_lock(context);
+    context->urc_defer_slots = slots;
+    urc_defer_unlock(context);
+    return ATC_SUCCESS;
+}
+
+//在事件循环中调用：复制URC行到槽中，按处理函数的深度限制和溢出策略处理
+void urc_defer_enqueue(struct atc_context *context, const struct urc_handler_entry *entry, const char *line_data, size_t length){
+    if(context->urc_defer_slots == NULL){
+        return;
+    }
+    if(length >= ATC_URC_DEFER_SLOT_SIZE){
+        LOG_WARN("URC too long for defer slot, id:%d, length:%zu", entry->id, length);
+        urc_defer_lock(context);
+        context->urc_defer_stats.dropped++;
+        urc_defer_unlock(context);
+        return;
+    }
+    urc_defer_lock(context);
+    //统计该处理函数的待派发数量，同时找空闲槽、该处理函数最早的槽、全局最早的槽
+    struct urc_defer_slot *free_slot = NULL;
+    struct urc_defer_slot *oldest_own = NULL;
+    struct urc_defer_slot *oldest_any = NULL;
+    size_t pending = 0;
+    for(size_t i = 0; i < ATC_URC_DEFER_QUEUE_DEPTH; i++){
+        struct urc_defer_slot *slot = &context->urc_defer_slots[i];
+        if(slot->state == URC_DEFER_SLOT_FREE){
+            if(free_slot == NULL) free_slot = slot;
+            continue;
+        }
+        if(slot->state != URC_DEFER_SLOT_PENDING){
+            continue;
+        }
+        if(slot->id == entry->id){
+            pending++;
+            if(oldest_own == NULL || (int32_t)(slot->seq - oldest_own->seq) < 0) oldest_own = slot;
+        }
+        if(oldest_any == NULL || (int32_t)(slot->seq - oldest_any->seq) < 0) oldest_any = slot;
+    }
+
+    struct urc_defer_slot *target = free_slot;
+    bool limit_hit = entry->options.max_pending != 0 && pending >= entry->options.max_pending;
+    if(limit_hit || target == NULL){
+        //超过处理函数深度限制只覆盖自己的槽；队列满时覆盖全局最早的槽
+        struct urc_defer_slot *victim = limit_hit ? oldest_own : oldest_any;
+        if(entry->options.overflow_policy == ATC_URC_OVERFLOW_OVERWRITE_OLDEST && victim != NULL){
+            target = victim;
+            context->urc_defer_stats.overwritten++;
+        }
+        else{
+            target = NULL;
+            context->urc_defer_stats.dropped++;
+        }
+    }
+    if(target != NULL){
+        target->state = URC_DEFER_SLOT_PENDING;
+        target->seq = context->urc_defer_seq++;
+        target->id = entry->id;
+        target->handler = entry->handler;
+        target->length = length;
+        memcpy(target->line, line_data, length);
+        target->line[length] = '\0';
+        context->urc_defer_stats.enqueued++;
+    }
+    urc_defer_unlock(context);
+
+    if(target != NULL){
+        //唤醒派发线程
+        g_atc_interface.atc_semaphore_give(context->urc_defer_semaphore);
+    }
+    else{
+        LOG_WARN("URC defer queue full, drop id:%d", entry->id);
+    }
+}
+
+//在事件循环中反注册时调用：丢弃该ID尚未派发的URC，正在派发的槽标记为已取消
+void urc_defer_purge(struct atc_context *context, int id){
+    if(context->urc_defer_slots == NULL){
+        return;
+    }
+    urc_defer_lock(context);
+    for(size_t i = 0; i < ATC_URC_DEFER_QUEUE_DEPTH; i++){
+        struct urc_defer_slot *slot = &context->urc_defer_slots[i];
+        if(slot->id != id){
+            continue;
+        }
+        if(slot->state == URC_DEFER_SLOT_PENDING){
+            slot->state = URC_DEFER_SLOT_FREE;
+        }
+        else if(slot->state == URC_DEFER_SLOT_DISPATCHING){
+            slot->cancelled = true;
+        }
+    }
+    urc_defer_unlock(context);
+}
+
+//在反注册的调用者线程中调用：等待已取消的槽派发结束。处理函数内禁止反注册，这里等待不会死锁
+void urc_defer_wait_cancelled(struct atc_context *context, int id){
+    if(context->urc_defer_slots == NULL){
+        return;
+    }
+    for(;;){
+        bool running = false;
+        urc_defer_lock(context);
+        for(size_t i = 0; i < ATC_URC_DEFER_QUEUE_DEPTH; i++){
+            struct urc_defer_slot *slot = &context->urc_defer_slots[i];
+            if(slot->state == URC_DEFER_SLOT_DISPATCHING && slot->cancelled && slot->id == id){
+                running = true;
+            }
+        }
+        urc_defer_unlock(context);
+        if(!running){
+            return;
+        }
+        //多个反注册同时等待时可能错过通知，限时等待后重新检查
+        g_atc_interface.atc_semaphore_take(context->urc_defer_done_semaphore, 10);
+    }
+}
+
+int atc_urc_dispatch(struct atc_context *context, uint32_t timeout){
+    if(context == NULL || context->urc_defer_semaphore == NULL){
+        return -1;
+    }
+    g_atc_interface.atc_semaphore_take(context->urc_defer_semaphore, timeout);
+    if(context->urc_defer_slots == NULL){
+        return 0;
+    }
+    int count = 0;
+    for(;;){
+        //按入队顺序取最早的槽，处理函数执行期间槽不可被覆盖，无需复制
+        urc_defer_lock(context);
+        struct urc_defer_slot *oldest = NULL;
+        for(size_t i = 0; i < ATC_URC_DEFER_QUEUE_DEPTH; i++){
+            struct urc_defer_slot *slot = &context->urc_defer_slots[i];
+            if(slot->state == URC_DEFER_SLOT_PENDING && (oldest == NULL || (int32_t)(slot->seq - oldest->seq) < 0)){
+                oldest = slot;
+            }
+        }
+        if(oldest != NULL){
+            oldest->state = URC_DEFER_SLOT_DISPATCHING;
+            oldest->cancelled = false;
+        }
+        urc_defer_unlock(context);
+        if(oldest == NULL){
+            break;
+        }
+
+        //取出后被反注册的槽不再执行
+        urc_defer_lock(context);
+        atc_urc_handler_t handler = oldest->cancelled ? NULL : oldest->handler;
+        urc_defer_unlock(context);
+        if(handler){
+            handler(context, oldest->line);
+            count++;
+        }
+
+        urc_defer_lock(context);
+        bool cancelled = oldest->cancelled;
+        oldest->state = URC_DEFER_SLOT_FREE;
+        oldest->cancelled = false;
+        if(handler){
+            context->urc_defer_stats.dispatched++;
+        }
+        urc_defer_unlock(context);
+        if(cancelled){
+            g_atc_interface.atc_semaphore_give(context->urc_defer_done_semaphore);
+        }
+    }
+    return count;
+}
+
+enum atc_result atc_urc_defer_get_stats(struct atc_context *context, struct atc_urc_defer_stats *stats){
+    if(context == NULL || stats == NULL || context->urc_defer_lock == NULL){
+        return ATC_ERROR;
+    }
+    urc_defer_lock(context);
+    *stats = context->urc_defer_stats;
+    urc_defer_unlock(context);
+    return ATC_SUCCESS;
+}
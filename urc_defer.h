@@ -0,0 +1,28 @@
+#ifndef URC_DEFER_H
+#define URC_DEFER_H
+#include "include/ATCortex.h"
+
+struct urc_handler_entry;
+
+//延迟URC队列槽
+struct urc_defer_slot{
+    enum {
+        URC_DEFER_SLOT_FREE = 0,    //空闲
+        URC_DEFER_SLOT_PENDING,     //等待派发
+        URC_DEFER_SLOT_DISPATCHING, //正在执行处理函数，不可覆盖
+    } state;
+    bool cancelled;                 //派发中被反注册：尚未执行时丢弃，执行完时通知等待的反注册调用者
+    uint32_t seq;                   //入队序号，越小越早
+    int id;                         //URC注册ID
+    atc_urc_handler_t handler;
+    size_t length;
+    char line[ATC_URC_DEFER_SLOT_SIZE];
+};
+
+enum atc_result urc_defer_init(struct atc_context *context);
+enum atc_result urc_defer_slots_alloc(struct atc_context *context);
+void urc_defer_enqueue(struct atc_context *context, const struct urc_handler_entry *entry, const char *line_data, size_t length);
+void urc_defer_purge(struct atc_context *context, int id);
+void urc_defer_wait_cancelled(struct atc_context *context, int id);
+
+#endif // URC_DEFER_H
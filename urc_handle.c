@@ -1,34 +1,285 @@
 #include "urc_handle.h"
 #include "log.h"
+#include "urc_defer.h"
+#include "urc_rate.h"
 #include <limits.h>
 #include <string.h>
 
 static void urc_free(void *data){
-    if(data) g_atc_interface.atc_free(data);
+    struct urc_handler_entry *entry = (struct urc_handler_entry *)data;
+    if(entry == NULL){
+        return;
+    }
+    if(entry->rate_lines){
+        g_atc_interface.atc_free(entry->rate_lines);
+    }
+    g_atc_interface.atc_free(entry);
+}
+
+//开始接收URC二进制负载：以头部调用处理函数并解析负载长度。header 以'\0'结尾，位于 line_buffer 中
+static void urc_payload_start(struct atc_context *context, const struct urc_handler_entry *entry, const char *header, size_t header_length){
+    if(entry->handler){
+        entry->handler(context, header);
+    }
+    size_t total = entry->options.payload_length(header, header_length);
+    LOG_DEBUG("URC id:%d payload length:%zu", entry->id, total);
+    if(total == 0){
+        return;
+    }
+    context->urc_payload_handler = entry->options.payload_handler;
+    context->urc_payload_id = entry->id;
+    context->urc_payload_total = total;
+    context->urc_payload_received = 0;
+}
+
+static bool urc_payload_is_inline(const struct urc_handler_entry *entry){
+    return entry->options.payload_length != NULL
+        && entry->options.payload_delimiter != '\0' && entry->options.payload_delimiter != '\n';
+}
+
+//交给处理函数或延迟队列，line_data 以'\0'结尾
+void urc_handler_invoke(struct atc_context *context, const struct urc_handler_entry *entry, const char *line_data, size_t length){
+    if(entry->options.deferred){
+        //延迟派发：只复制到队列，不在事件循环中执行处理函数
+        urc_defer_enqueue(context, entry, line_data, length);
+    }
+    else if(entry->handler){
+        entry->handler(context, line_data);
+    }
+}
+
+//经过限流后交付
+static void urc_deliver(struct atc_context *context, struct urc_handler_entry *entry, const char *line_data, size_t length){
+    if(entry->options.min_interval_ms != 0 && !urc_rate_offer(context, entry, line_data, length)){
+        return;
+    }
+    urc_handler_invoke(context, entry, line_data, length);
+}
+
+//多行聚合结束，整条URC一次交给处理函数
+static void urc_aggregate_finish(struct atc_context *context){
+    struct urc_handler_entry *entry = context->urc_aggregate_entry;
+    context->urc_aggregate_entry = NULL;
+    context->urc_aggregate_buffer[context->urc_aggregate_length] = '\0';
+    LOG_DEBUG("URC id:%d aggregated %zu bytes", entry->id, context->urc_aggregate_length);
+    urc_deliver(context, entry, context->urc_aggregate_buffer, context->urc_aggregate_length);
+}
+
+//追加一行到聚合缓冲区，超长时丢弃整条URC，后续行恢复正常解析
+static bool urc_aggregate_append(struct atc_context *context, const char *line_data, size_t length){
+    if(context->urc_aggregate_length + length >= ATC_URC_AGGREGATE_MAX_SIZE){   //保留一个字节给字符串结束符
+        LOG_WARN("URC id:%d aggregate overflow, discarding", context->urc_aggregate_entry->id);
+        context->urc_aggregate_entry = NULL;
+        return false;
+    }
+    memcpy(&context->urc_aggregate_buffer[context->urc_aggregate_length], line_data, length);
+    context->urc_aggregate_length += length;
+    return true;
+}
+
+//以头部行开始多行聚合
+static void urc_aggregate_start(struct atc_context *context, struct urc_handler_entry *entry, const char *line_data, size_t length){
+    context->urc_aggregate_entry = entry;
+    context->urc_aggregate_lines = entry->options.aggregate_lines;
+    context->urc_aggregate_length = 0;
+    if(!urc_aggregate_append(context, line_data, length)){
+        return;
+    }
+    if(entry->options.aggregate == ATC_URC_AGGREGATE_LINES && context->urc_aggregate_lines == 0){
+        urc_aggregate_finish(context);
+    }
+}
+
+//前缀树遍历参数
+struct urc_dispatch_arg{
+    struct atc_context *context;
+    const char *line_data;
+    size_t length;
+    bool is_urc;
+};
+
+//前缀树遍历回调：line_data 以该节点的前缀开头，依次调用该前缀下的所有处理函数
+static bool urc_dispatch_visit(void *value, size_t prefix_length, void *arg){
+    struct urc_dispatch_arg *dispatch = (struct urc_dispatch_arg *)arg;
+    struct urc_handler_entry *entry = (struct urc_handler_entry *)value;
+    if(!dispatch->is_urc && dispatch->line_data != dispatch->context->line_buffer){
+        //处理函数需要以'\0'结尾的字符串，零拷贝行先复制到空闲的行缓冲区
+        memcpy(dispatch->context->line_buffer, dispatch->line_data, dispatch->length);
+        dispatch->context->line_buffer[dispatch->length] = '\0';
+        dispatch->line_data = dispatch->context->line_buffer;
+    }
+    dispatch->is_urc = true;
+    for(; entry != NULL; entry = entry->next){
+        //匹配到URC前缀，调用处理函数
+        LOG_DEBUG("Match id:%d, prefix length:%zu", entry->id, prefix_length);
+        if(entry->options.payload_length != NULL && !urc_payload_is_inline(entry)){
+            //负载在头部行之后，同一行只开始一次接收
+            if(dispatch->context->urc_payload_received >= dispatch->context->urc_payload_total){
+                urc_payload_start(dispatch->context, entry, dispatch->line_data, dispatch->length);
+            }
+        }
+        else if(entry->options.aggregate != ATC_URC_AGGREGATE_NONE){
+            //后续行由 urc_aggregate_line_handle 收集，同一时间只聚合一条URC
+            if(dispatch->context->urc_aggregate_entry == NULL){
+                urc_aggregate_start(dispatch->context, entry, dispatch->line_data, dispatch->length);
+            }
+        }
+        else{
+            urc_deliver(dispatch->context, entry, dispatch->line_data, dispatch->length);
+        }
+    }
+    return true;
 }
 
 //URC行处理,返回true表示匹配到URC前缀并处理，false表示未匹配到URC前缀
-bool urc_line_handle(struct atc_context *context, const char *line_data){
-    bool is_urc = false;
+//line_data 可能直接指向环形缓冲区，不保证以'\0'结尾，长度小于 ATC_RX_LINE_MAX_SIZE
+//沿前缀树对行只下行一次，耗时与前缀长度成正比，与已注册的URC数量无关
+bool urc_line_handle(struct atc_context *context, const char *line_data, size_t length){
     if(line_data == NULL){
         return false;
     }
     LOG_TRACE;
-    //遍历URC处理链表
+    struct urc_dispatch_arg dispatch = {
+        .context = context,
+        .line_data = line_data,
+        .length = length,
+        .is_urc = false,
+    };
+    trie_foreach_prefix(context->urc_prefix_trie, line_data, length, urc_dispatch_visit, &dispatch);
+    return dispatch.is_urc;
+}
+
+//多行URC聚合中的行处理，返回true表示该行属于正在聚合的URC。line_data 不保证以'\0'结尾，可能为空行
+bool urc_aggregate_line_handle(struct atc_context *context, const char *line_data, size_t length){
+    const struct urc_handler_entry *entry = context->urc_aggregate_entry;
+    if(entry == NULL){
+        return false;
+    }
+    bool blank = length <= 2;
+    switch(entry->options.aggregate){
+    case ATC_URC_AGGREGATE_LINES:
+        if(!blank && urc_aggregate_append(context, line_data, length) && --context->urc_aggregate_lines == 0){
+            urc_aggregate_finish(context);
+        }
+        break;
+    case ATC_URC_AGGREGATE_UNTIL_BLANK:
+        if(blank){
+            urc_aggregate_finish(context);
+        }
+        else{
+            urc_aggregate_append(context, line_data, length);
+        }
+        break;
+    case ATC_URC_AGGREGATE_UNTIL_TERMINATOR:{
+        if(blank){
+            break;
+        }
+        size_t term_length = strlen(entry->options.aggregate_terminator);
+        if(urc_aggregate_append(context, line_data, length)
+            && length >= term_length && memcmp(line_data, entry->options.aggregate_terminator, term_length) == 0){
+            urc_aggregate_finish(context);
+        }
+        break;
+    }
+    default:
+        context->urc_aggregate_entry = NULL;
+        break;
+    }
+    return true;
+}
+
+//同一行内负载头部匹配参数
+struct urc_payload_arg{
+    char delimiter;
+    const struct urc_handler_entry *entry;
+};
+
+static bool urc_payload_visit(void *value, size_t prefix_length, void *arg){
+    struct urc_payload_arg *match = (struct urc_payload_arg *)arg;
+    (void)prefix_length;
+    for(const struct urc_handler_entry *entry = value; entry != NULL; entry = entry->next){
+        if(urc_payload_is_inline(entry) && entry->options.payload_delimiter == match->delimiter){
+            match->entry = entry;
+            return false;
+        }
+    }
+    return true;
+}
+
+//同一行内负载头部处理：header 以头部结束符结尾，长度小于 ATC_RX_LINE_MAX_SIZE，可能直接指向环形缓冲区
+//匹配到以该结束符声明负载的URC时开始接收负载并返回true
+bool urc_payload_header_handle(struct atc_context *context, const char *header, size_t length){
+    struct urc_payload_arg match = {
+        .delimiter = header[length - 1],
+        .entry = NULL,
+    };
+    trie_foreach_prefix(context->urc_prefix_trie, header, length, urc_payload_visit, &match);
+    if(match.entry == NULL){
+        return false;
+    }
+    //头部在负载接收期间保留在行缓冲区
+    if(header != context->line_buffer){
+        memcpy(context->line_buffer, header, length);
+    }
+    context->line_buffer[length] = '\0';
+    urc_payload_start(context, match.entry, context->line_buffer, length);
+    return true;
+}
+
+//URC负载接收状态：把连续可读数据直接交给负载回调，返回已消费的字节数
+size_t urc_payload_handle(struct atc_context *context, const char *data, size_t length){
+    size_t remaining = context->urc_payload_total - context->urc_payload_received;
+    size_t used = length < remaining ? length : remaining;
+    //处理函数已反注册时丢弃剩余负载
+    if(context->urc_payload_handler){
+        context->urc_payload_handler(context, context->line_buffer, data, used,
+                                        context->urc_payload_received, context->urc_payload_total);
+    }
+    context->urc_payload_received += used;
+    if(context->urc_payload_received == context->urc_payload_total){
+        LOG_DEBUG("URC id:%d payload received", context->urc_payload_id);
+    }
+    return used;
+}
+
+//重建同一行内负载头部结束符位图
+static void urc_payload_delimiters_update(struct atc_context *context){
+    memset(context->urc_payload_delimiters, 0, sizeof(context->urc_payload_delimiters));
+    context->urc_payload_inline = false;
     slist_node_t *node;
     SLIST_FOREACH(node, context->urc_handler_list){
         struct urc_handler_entry *entry = (struct urc_handler_entry *)node->data;
-        LOG_DEBUG("Checking URC handler id:%d, prefix:%s, line_data:%s", entry->id, entry->prefix, line_data);
-        if(entry && strncmp(line_data, entry->prefix, strlen(entry->prefix)) == 0){
-            //匹配到URC前缀，调用处理函数
-            LOG_DEBUG("Match id:%d",entry->id);
-            if(entry->handler){
-                entry->handler(context, line_data);
-            }
-            is_urc = true;
+        if(entry && urc_payload_is_inline(entry)){
+            unsigned char c = (unsigned char)entry->options.payload_delimiter;
+            context->urc_payload_delimiters[c >> 5] |= 1u << (c & 31);
+            context->urc_payload_inline = true;
+        }
+    }
+}
+
+//从前缀索引中摘除条目，前缀下没有其他处理函数时删除该前缀
+static void urc_index_remove(struct atc_context *context, struct urc_handler_entry *entry){
+    size_t prefix_len = strlen(entry->prefix);
+    void **slot = trie_find_slot(context->urc_prefix_trie, entry->prefix, prefix_len);
+    if(slot == NULL){
+        return;
+    }
+    struct urc_handler_entry *head = (struct urc_handler_entry *)*slot;
+    if(head == entry){
+        if(entry->next != NULL){
+            *slot = entry->next;
+        }
+        else{
+            trie_remove(context->urc_prefix_trie, entry->prefix, prefix_len);
+        }
+        return;
+    }
+    for(; head->next != NULL; head = head->next){
+        if(head->next == entry){
+            head->next = entry->next;
+            return;
         }
     }
-    return is_urc;
 }
 
 enum atc_result urc_init(struct atc_context *context){
@@ -41,6 +292,14 @@ enum atc_result urc_init(struct atc_context *context){
         }
         context->urc_next_id = 1; // ID从1开始分配
     }
+    //初始化URC前缀索引，条目内存由链表管理
+    if(context->urc_prefix_trie == NULL){
+        context->urc_prefix_trie = trie_create(NULL);
+        if(context->urc_prefix_trie == NULL){
+            LOG_ERR("Failed to create urc prefix trie");
+            return ATC_ERROR;
+        }
+    }
 
     return ATC_SUCCESS;
 }
@@ -79,6 +338,10 @@ int _atc_urc_register(struct atc_context *context , struct urc_handler_entry *en
 
     LOG_DEBUG("prefix:%s, register urc handler, id:%d", entry->prefix, assigned_id);
 
+    if(entry->options.deferred && urc_defer_slots_alloc(context) != ATC_SUCCESS){
+        return -1;
+    }
+
     struct urc_handler_entry *tmp = g_atc_interface.atc_malloc(sizeof(struct urc_handler_entry));
     if(tmp == NULL){
         LOG_ERR("Failed to allocate memory for urc_handler_entry");
@@ -86,11 +349,36 @@ int _atc_urc_register(struct atc_context *context , struct urc_handler_entry *en
     }
     *tmp = *entry;
     tmp->id = assigned_id; // 填入分配的ID
+    tmp->next = NULL;
+    tmp->rate_count = 0;
+    tmp->rate_lines = NULL;
+    memset(&tmp->rate_timer, 0, sizeof(tmp->rate_timer));
+    if(tmp->options.min_interval_ms != 0 && urc_rate_alloc(tmp) != ATC_SUCCESS){
+        g_atc_interface.atc_free(tmp);
+        return -1;
+    }
+    //加入前缀索引：同一前缀的处理函数按注册顺序串成链
+    size_t prefix_len = strlen(tmp->prefix);
+    void **slot = trie_find_slot(context->urc_prefix_trie, tmp->prefix, prefix_len);
+    if(slot != NULL){
+        struct urc_handler_entry *last = (struct urc_handler_entry *)*slot;
+        while(last->next) last = last->next;
+        last->next = tmp;
+    }
+    else if(trie_insert(context->urc_prefix_trie, tmp->prefix, prefix_len, tmp) != 0){
+        LOG_ERR("Failed to insert urc handler entry to prefix trie");
+        urc_free(tmp);
+        return -1;
+    }
     if(slist_append(context->urc_handler_list, tmp) != 0){
         LOG_ERR("Failed to append urc handler entry to list");
-        g_atc_interface.atc_free(tmp);
+        urc_index_remove(context, tmp);
+        urc_free(tmp);
         return -1;
     }
+    if(urc_payload_is_inline(tmp)){
+        urc_payload_delimiters_update(context);
+    }
     return assigned_id;
 }
 
@@ -104,8 +392,21 @@ enum atc_result _atc_urc_unregister(struct atc_context *context, int id){
     SLIST_FOREACH(node, context->urc_handler_list){
         struct urc_handler_entry *entry = (struct urc_handler_entry *)node->data;
         if(entry && entry->id == id){
+            urc_index_remove(context, entry);
+            urc_defer_purge(context, id);
+            if(context->urc_payload_id == id){
+                context->urc_payload_handler = NULL;
+            }
+            if(context->urc_aggregate_entry == entry){
+                context->urc_aggregate_entry = NULL;
+            }
+            urc_rate_free(context, entry);
+            bool is_inline = urc_payload_is_inline(entry);
             // slist_remove 按 data 指针匹配，会调用 free_fn 释放数据，立即 return 安全
             slist_remove(context->urc_handler_list, node->data);
+            if(is_inline){
+                urc_payload_delimiters_update(context);
+            }
             LOG_DEBUG("Unregistered URC handler id:%d", id);
             return ATC_SUCCESS;
         }
@@ -1,15 +1,29 @@
 #ifndef URC_HANDLE_H
 #define URC_HANDLE_H
 #include "include/ATCortex.h"
+#include "urc_rate.h"
+#include "timer_wheel.h"
 
 struct urc_handler_entry{
     int id;                     // 注册ID，由_atc_urc_register分配
     char prefix[32];
     atc_urc_handler_t handler;
+    struct atc_urc_options options;
+    struct urc_handler_entry *next;  // 前缀树中同一前缀的下一个处理函数（按注册顺序）
+    //限流状态，options.min_interval_ms 非0时有效
+    uint32_t rate_last_time;         // 上次交付时间
+    uint16_t rate_head;              // 最早暂存行的位置
+    uint16_t rate_count;             // 暂存行数
+    struct urc_rate_line *rate_lines;
+    struct timer_node rate_timer;    // 有暂存行时在间隔到期时交付
 };
 enum atc_result urc_init(struct atc_context *context);
 int _atc_urc_register(struct atc_context *context , struct urc_handler_entry *entry);
 enum atc_result _atc_urc_unregister(struct atc_context *context, int id);
-bool urc_line_handle(struct atc_context *context, const char *line_data);
+void urc_handler_invoke(struct atc_context *context, const struct urc_handler_entry *entry, const char *line_data, size_t length);
+bool urc_line_handle(struct atc_context *context, const char *line_data, size_t length);
+bool urc_aggregate_line_handle(struct atc_context *context, const char *line_data, size_t length);
+bool urc_payload_header_handle(struct atc_context *context, const char *header, size_t length);
+size_t urc_payload_handle(struct atc_context *context, const char *data, size_t length);
 
 #endif // URC_HANDLE_H
\ No newline at end of file
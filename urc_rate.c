@@ -0,0 +1,88 @@
+/**
+ * @Description: URC限流模块
+ *               同一处理函数两次交付之间至少间隔 min_interval_ms，间隔内到达的URC只保留最近 coalesce_keep 条，
+ *               间隔到期后由时间轮定时器一次交付，其余计入 suppressed_count
+ */
+
+#include "urc_rate.h"
+#include "urc_handle.h"
+#include "timer_wheel.h"
+#include "log.h"
+#include <string.h>
+
+static uint16_t urc_rate_keep(const struct urc_handler_entry *entry){
+    return entry->options.coalesce_keep ? entry->options.coalesce_keep : 1;
+}
+
+static void urc_rate_suppress(const struct urc_handler_entry *entry){
+    if(entry->options.suppressed_count){
+        (*entry->options.suppressed_count)++;
+    }
+}
+
+//限流间隔到期：交付暂存的URC
+static void urc_rate_expired(struct atc_context *context, void *arg){
+    struct urc_handler_entry *entry = (struct urc_handler_entry *)arg;
+    uint16_t keep = urc_rate_keep(entry);
+    entry->rate_last_time = _atc_time_get();
+    while(entry->rate_count > 0){
+        struct urc_rate_line *slot = &entry->rate_lines[entry->rate_head];
+        entry->rate_head = (uint16_t)((entry->rate_head + 1) % keep);
+        entry->rate_count--;
+        urc_handler_invoke(context, entry, slot->line, slot->length);
+    }
+}
+
+//注册时分配暂存行，允许首条URC立即交付
+enum atc_result urc_rate_alloc(struct urc_handler_entry *entry){
+    entry->rate_lines = g_atc_interface.atc_malloc(sizeof(struct urc_rate_line) * urc_rate_keep(entry));
+    if(entry->rate_lines == NULL){
+        LOG_ERR("Failed to allocate memory for urc rate lines");
+        return ATC_ERROR;
+    }
+    entry->rate_head = 0;
+    entry->rate_count = 0;
+    entry->rate_last_time = _atc_time_get() - entry->options.min_interval_ms;
+    return ATC_SUCCESS;
+}
+
+//反注册时丢弃暂存行
+void urc_rate_free(struct atc_context *context, struct urc_handler_entry *entry){
+    timer_stop(context, &entry->rate_timer);
+    entry->rate_count = 0;
+    if(entry->rate_lines){
+        g_atc_interface.atc_free(entry->rate_lines);
+        entry->rate_lines = NULL;
+    }
+}
+
+//在事件循环中调用：返回true表示间隔已到，调用者立即交付；否则URC已暂存或被合并
+bool urc_rate_offer(struct atc_context *context, struct urc_handler_entry *entry, const char *line_data, size_t length){
+    uint32_t now = _atc_time_get();
+    if(entry->rate_count == 0 && now - entry->rate_last_time >= entry->options.min_interval_ms){
+        entry->rate_last_time = now;
+        return true;
+    }
+    if(length >= ATC_URC_RATE_LINE_SIZE){
+        LOG_WARN("URC too long for rate limit, id:%d, length:%zu", entry->id, length);
+        urc_rate_suppress(entry);
+        return false;
+    }
+    uint16_t keep = urc_rate_keep(entry);
+    if(entry->rate_count == keep){
+        //合并：丢弃最早暂存的一条
+        entry->rate_head = (uint16_t)((entry->rate_head + 1) % keep);
+        entry->rate_count--;
+        urc_rate_suppress(entry);
+    }
+    else if(entry->rate_count == 0){
+        //首条暂存：间隔到期时交付
+        timer_start(context, &entry->rate_timer, entry->rate_last_time + entry->options.min_interval_ms, 0, urc_rate_expired, entry);
+    }
+    struct urc_rate_line *slot = &entry->rate_lines[(entry->rate_head + entry->rate_count) % keep];
+    memcpy(slot->line, line_data, length);
+    slot->line[length] = '\0';
+    slot->length = length;
+    entry->rate_count++;
+    return false;
+}
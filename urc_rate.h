@@ -0,0 +1,17 @@
+#ifndef URC_RATE_H
+#define URC_RATE_H
+#include "include/ATCortex.h"
+
+struct urc_handler_entry;
+
+//限流暂存的URC行
+struct urc_rate_line{
+    size_t length;
+    char line[ATC_URC_RATE_LINE_SIZE];
+};
+
+enum atc_result urc_rate_alloc(struct urc_handler_entry *entry);
+void urc_rate_free(struct atc_context *context, struct urc_handler_entry *entry);
+bool urc_rate_offer(struct atc_context *context, struct urc_handler_entry *entry, const char *line_data, size_t length);
+
+#endif // URC_RATE_H
@@ -0,0 +1,44 @@
+/**
+ * @Description: 同步调用等待信号量池
+ *               同步API阻塞等待事件循环时使用的二值信号量用完后放回池中复用，
+ *               热路径上只剩一次队列收发和一对 take/give，不再每次创建/删除内核对象
+ */
+
+#include "wait_pool.h"
+#include "log.h"
+
+enum atc_result wait_pool_init(struct atc_context *context, const struct atc_config *config){
+    uint16_t size = (config && config->wait_semaphore_pool_size) ? config->wait_semaphore_pool_size : ATC_WAIT_SEMAPHORE_POOL_SIZE;
+    //信号量在首次使用时创建，释放时放入池中
+    context->wait_semaphore_pool = g_atc_interface.atc_queue_create(size, sizeof(void *));
+    if(context->wait_semaphore_pool == NULL){
+        LOG_ERR("Failed to create wait semaphore pool");
+        return ATC_ERROR;
+    }
+    return ATC_SUCCESS;
+}
+
+//取一个等待信号量，池空时创建新的
+void *wait_semaphore_acquire(struct atc_context *context){
+    void *semaphore = NULL;
+    if(context->wait_semaphore_pool != NULL
+        && g_atc_interface.atc_queue_recv(context->wait_semaphore_pool, &semaphore, 0) == ATC_SUCCESS){
+        return semaphore;
+    }
+    semaphore = g_atc_interface.atc_semaphore_create_binary();
+    if(semaphore == NULL){
+        LOG_ERR("Failed to create wait semaphore");
+    }
+    return semaphore;
+}
+
+//归还等待信号量。调用前信号量已被 take 消耗，处于未释放状态；池满时删除
+void wait_semaphore_release(struct atc_context *context, void *semaphore){
+    if(semaphore == NULL){
+        return;
+    }
+    if(context->wait_semaphore_pool == NULL
+        || g_atc_interface.atc_queue_send(context->wait_semaphore_pool, &semaphore, 0) != ATC_SUCCESS){
+        g_atc_interface.atc_semaphore_delete(semaphore);
+    }
+}
@@ -0,0 +1,9 @@
+#ifndef WAIT_POOL_H
+#define WAIT_POOL_H
+#include "include/ATCortex.h"
+
+enum atc_result wait_pool_init(struct atc_context *context, const struct atc_config *config);
+void *wait_semaphore_acquire(struct atc_context *context);
+void wait_semaphore_release(struct atc_context *context, void *semaphore);
+
+#endif // WAIT_POOL_H